@@ -0,0 +1,144 @@
+// Host benchmark for AsyncWiFiSettings. For each parameter count, a child
+// process registers that many parameters, renders the portal and saves it,
+// and prints one JSON object per line:
+//
+//   {"params":100,"load_us":...,"render_us":...,"render_bytes":...,
+//    "render_allocs":...,"render_peak_bytes":...,"save_us":...,
+//    "save_allocs":...,"save_peak_bytes":...}
+//
+// Times are medians over the given number of iterations. Usage:
+//
+//   bench [iterations] [params...]     (default: 25 10 100 500)
+
+#include <AsyncWiFiSettings.h>
+#include <SPIFFS.h>
+#include <WiFi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "heap.h"
+
+namespace {
+    AsyncWebServer *server;
+
+    uint64_t now_us() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    uint64_t median(std::vector<uint64_t> v) {
+        std::sort(v.begin(), v.end());
+        return v[v.size() / 2];
+    }
+
+    String key(int i) {
+        return "bench_" + String(i);
+    }
+
+    // A mix of parameter types, roughly like real firmware
+    void define(int n) {
+        static const char *const options[] = {"one", "two", "three", "four", "five"};
+        for (int i = 0; i < n; i++) {
+            if (i % 25 == 0) AsyncWiFiSettings.heading("Section " + String(i / 25));
+            switch (i % 5) {
+                case 0: AsyncWiFiSettings.string(key(i), "default <value> " + String(i)); break;
+                case 1: AsyncWiFiSettings.integer(key(i), 0, 65535, i); break;
+                case 2: AsyncWiFiSettings.checkbox(key(i), i % 2); break;
+                case 3: AsyncWiFiSettings.floating(key(i), -100, 100, i / 10.0); break;
+                case 4: AsyncWiFiSettings.dropdown(key(i), options, 5, 1); break;
+            }
+        }
+    }
+
+    struct Measurement {
+        uint64_t us;
+        size_t bytes;
+        uint64_t allocs;
+        size_t peak;
+    };
+
+    Measurement request(AsyncWebServerRequest &r) {
+        HeapStats before = heap_stats();
+        heap_reset_peak();
+        uint64_t start = now_us();
+        server->dispatch(&r);
+        uint64_t us = now_us() - start;
+        HeapStats after = heap_stats();
+        return {us, r._response ? r._response->body.length() : 0, after.allocations - before.allocations, after.peak - before.in_use};
+    }
+
+    void run(int params, int iterations) {
+        // Half of the parameters have a stored value, like a device that
+        // has been configured before.
+        for (int i = 0; i < params; i += 2) {
+            File f = SPIFFS.open("/" + key(i), "w");
+            f.print(String(i % 5 == 2 ? 1 : i));
+            f.close();
+        }
+        SPIFFS.open("/wifi-ssid", "w").print("network 3");
+        for (int i = 0; i < 10; i++) WiFi.ssids.push_back("network " + String(i));
+
+        uint64_t start = now_us();
+        AsyncWiFiSettings.begin();
+        define(params);
+        uint64_t load_us = now_us() - start;
+
+        AsyncWiFiSettings.onHttpSetup = [](AsyncWebServer *s) { server = s; };
+        AsyncWiFiSettings.httpSetup(true);
+
+        std::vector<uint64_t> render_us, save_us;
+        Measurement render = {}, save = {};
+        for (int it = 0; it < iterations; it++) {
+            AsyncWebServerRequest get;
+            get._url = "/";
+            get._headers.push_back(AsyncWebHeader("User-Agent", "Mozilla/5.0"));
+            render = request(get);
+            render_us.push_back(render.us);
+
+            AsyncWebServerRequest post;
+            post._method = HTTP_POST;
+            post._url = "/";
+            post._params.push_back(AsyncWebParameter("ssid", "network 3", true));
+            post._params.push_back(AsyncWebParameter("password", "##**##**##**", true));
+            post._params.push_back(AsyncWebParameter("language", "en", true));
+            for (int i = 0; i < params; i++) {
+                post._params.push_back(AsyncWebParameter(key(i), String((i + it) % 3), true));
+            }
+            save = request(post);
+            save_us.push_back(save.us);
+        }
+
+        printf(
+            "{\"params\":%d,\"load_us\":%llu,\"render_us\":%llu,\"render_bytes\":%zu,"
+            "\"render_allocs\":%llu,\"render_peak_bytes\":%zu,\"save_us\":%llu,"
+            "\"save_allocs\":%llu,\"save_peak_bytes\":%zu}\n",
+            params, (unsigned long long)load_us, (unsigned long long)median(render_us), render.bytes,
+            (unsigned long long)render.allocs, render.peak, (unsigned long long)median(save_us),
+            (unsigned long long)save.allocs, save.peak);
+        fflush(stdout);
+    }
+} // namespace
+
+int main(int argc, char **argv) {
+    int iterations = argc > 1 ? atoi(argv[1]) : 25;
+    std::vector<int> counts;
+    for (int i = 2; i < argc; i++) counts.push_back(atoi(argv[i]));
+    if (counts.empty()) counts = {10, 100, 500};
+
+    // The stubs keep the filesystem and scan results in globals, and the
+    // ready-made instance can't be reset, so every size gets a fresh process.
+    for (int params : counts) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            run(params, iterations);
+            _exit(0);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status)) return 1;
+    }
+    return 0;
+}
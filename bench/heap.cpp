@@ -0,0 +1,73 @@
+#include "heap.h"
+
+#include <malloc.h>
+
+extern "C" {
+    void *__libc_malloc(size_t size);
+    void *__libc_calloc(size_t n, size_t size);
+    void *__libc_realloc(void *ptr, size_t size);
+    void __libc_free(void *ptr);
+}
+
+namespace {
+    HeapStats stats;
+
+    void grow(void *p) {
+        if (!p) return;
+        stats.in_use += malloc_usable_size(p);
+        if (stats.in_use > stats.peak) stats.peak = stats.in_use;
+    }
+
+    void shrink(void *p) {
+        if (p) stats.in_use -= malloc_usable_size(p);
+    }
+} // namespace
+
+extern "C" {
+    void *malloc(size_t size) {
+        stats.allocations++;
+        void *p = __libc_malloc(size);
+        grow(p);
+        return p;
+    }
+
+    void *calloc(size_t n, size_t size) {
+        stats.allocations++;
+        void *p = __libc_calloc(n, size);
+        grow(p);
+        return p;
+    }
+
+    void *realloc(void *ptr, size_t size) {
+        stats.allocations++;
+        shrink(ptr);
+        void *p = __libc_realloc(ptr, size);
+        grow(p ? p : (size ? ptr : nullptr));
+        return p;
+    }
+
+    void free(void *ptr) {
+        shrink(ptr);
+        __libc_free(ptr);
+    }
+}
+
+HeapStats heap_stats() {
+    return stats;
+}
+
+void heap_reset_peak() {
+    stats.peak = stats.in_use;
+}
+
+// Make ESP.getFreeHeap() and friends in the stubs follow the real usage, as
+// if the process had the heap of an ESP32.
+static const uint32_t heap_size = 320 * 1024;
+
+uint32_t native_free_heap() {
+    return stats.in_use < heap_size ? heap_size - stats.in_use : 0;
+}
+
+uint32_t native_min_free_heap() {
+    return stats.peak < heap_size ? heap_size - stats.peak : 0;
+}
@@ -0,0 +1,14 @@
+// Counts heap usage of the whole process by interposing malloc and friends.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct HeapStats {
+    uint64_t allocations; // calls to malloc, calloc and realloc
+    size_t in_use;        // bytes
+    size_t peak;          // bytes, since the last heap_reset_peak()
+};
+
+HeapStats heap_stats();
+void heap_reset_peak();
@@ -0,0 +1,56 @@
+// Host stand-in for the Arduino core. Enough to build AsyncWiFiSettings on
+// Linux for benchmarking; nothing here talks to real hardware.
+#pragma once
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "Print.h"
+#include "Stream.h"
+#include "WString.h"
+
+#define ESP32 1
+#define LOW 0
+#define HIGH 1
+#define INPUT 0
+#define OUTPUT 1
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+long random(long max);
+long random(long min, long max);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+class HardwareSerial : public Print {
+    public:
+        void begin(unsigned long) {}
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buffer, size_t size) override;
+        using Print::write;
+        operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+    public:
+        uint64_t getEfuseMac() { return 0x0000AABBCCDDEEFFULL; }
+        uint32_t getFreeHeap();
+        uint32_t getMinFreeHeap();
+        uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+        void restart();
+};
+extern EspClass ESP;
+
+#include "IPAddress.h"
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "Arduino.h"
+
+class DNSServer {
+    public:
+        void setTTL(uint32_t) {}
+        bool start(uint16_t, const String &, const IPAddress &) { return true; }
+        void processNextRequest() {}
+};
@@ -0,0 +1,258 @@
+// Host stand-in for ESPAsyncWebServer. Handlers are recorded so a harness can
+// dispatch synthetic requests to them directly, without any networking.
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "Arduino.h"
+#include "FS.h"
+
+typedef enum {
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServerRequest;
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final)> ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)> ArBodyHandlerFunction;
+
+class AsyncWebHeader {
+    public:
+        AsyncWebHeader(const String &name, const String &value) : _name(name), _value(value) {}
+        const String &name() const { return _name; }
+        const String &value() const { return _value; }
+
+    private:
+        String _name;
+        String _value;
+};
+
+class AsyncWebParameter {
+    public:
+        AsyncWebParameter(const String &name, const String &value, bool form = false, bool file = false, size_t size = 0)
+            : _name(name), _value(value), _size(size), _isForm(form), _isFile(file) {}
+        const String &name() const { return _name; }
+        const String &value() const { return _value; }
+        size_t size() const { return _size; }
+        bool isPost() const { return _isForm; }
+        bool isFile() const { return _isFile; }
+
+    private:
+        String _name;
+        String _value;
+        size_t _size;
+        bool _isForm;
+        bool _isFile;
+};
+
+class AsyncWebServerResponse {
+    public:
+        virtual ~AsyncWebServerResponse() {}
+        int code = 200;
+        String contentType;
+        String body;
+        std::vector<std::pair<String, String>> headers;
+        void addHeader(const String &name, const String &value) { headers.push_back({name, value}); }
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print {
+    public:
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t *data, size_t len) override {
+            body.concat((const char *)data, (unsigned int)len);
+            return len;
+        }
+        using Print::write;
+};
+
+class AsyncWebServerRequest {
+    public:
+        // Host-side request description
+        WebRequestMethodComposite _method = HTTP_GET;
+        String _url = "/";
+        String _host = "192.168.4.1";
+        std::vector<AsyncWebHeader> _headers;
+        std::vector<AsyncWebParameter> _params;
+        AsyncWebServerResponse *_response = nullptr;
+        std::function<void(void)> _onDisconnect;
+        void *_tempObject = nullptr;
+
+        ~AsyncWebServerRequest() { delete _response; }
+
+        WebRequestMethodComposite method() const { return _method; }
+        const String &url() const { return _url; }
+        const String &host() const { return _host; }
+        bool hasHeader(const String &name) const { return getHeader(name) != nullptr; }
+        AsyncWebHeader *getHeader(const String &name) const {
+            for (auto &h : _headers) if (h.name() == name) return const_cast<AsyncWebHeader *>(&h);
+            return nullptr;
+        }
+        bool hasArg(const char *name) const {
+            for (auto &p : _params) if (p.name() == name) return true;
+            return false;
+        }
+        const String &arg(const String &name) const {
+            static const String empty;
+            for (auto &p : _params) if (p.name() == name) return p.value();
+            return empty;
+        }
+        size_t params() const { return _params.size(); }
+        AsyncWebParameter *getParam(size_t i) const { return const_cast<AsyncWebParameter *>(&_params[i]); }
+        bool hasParam(const String &name, bool post = false, bool file = false) const {
+            (void)post; (void)file;
+            return hasArg(name.c_str());
+        }
+        AsyncWebParameter *getParam(const String &name, bool post = false, bool file = false) const {
+            (void)post; (void)file;
+            for (auto &p : _params) if (p.name() == name) return const_cast<AsyncWebParameter *>(&p);
+            return nullptr;
+        }
+        void onDisconnect(std::function<void(void)> fn) { _onDisconnect = fn; }
+
+        AsyncResponseStream *beginResponseStream(const String &contentType, size_t bufferSize = 1460) {
+            (void)bufferSize;
+            auto *r = new AsyncResponseStream();
+            r->contentType = contentType;
+            return r;
+        }
+        AsyncWebServerResponse *beginResponse(int code, const String &contentType = String(), const String &content = String()) {
+            auto *r = new AsyncWebServerResponse();
+            r->code = code;
+            r->contentType = contentType;
+            r->body = content;
+            return r;
+        }
+        void send(AsyncWebServerResponse *response) {
+            delete _response;
+            _response = response;
+        }
+        void send(int code, const String &contentType = String(), const String &content = String()) {
+            send(beginResponse(code, contentType, content));
+        }
+        void redirect(const String &url) {
+            auto *r = beginResponse(302);
+            r->addHeader("Location", url);
+            send(r);
+        }
+};
+
+class AsyncWebHandler {
+    public:
+        virtual ~AsyncWebHandler() {}
+        virtual bool canHandle(AsyncWebServerRequest *request) = 0;
+        virtual void handleRequest(AsyncWebServerRequest *request) = 0;
+        virtual void handleUpload(AsyncWebServerRequest *, const String &, size_t, uint8_t *, size_t, bool) {}
+        virtual void handleBody(AsyncWebServerRequest *, uint8_t *, size_t, size_t, size_t) {}
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler {
+    public:
+        String uri;
+        WebRequestMethodComposite method = HTTP_ANY;
+        ArRequestHandlerFunction onRequest;
+        ArUploadHandlerFunction onUpload;
+        ArBodyHandlerFunction onBody;
+
+        bool canHandle(AsyncWebServerRequest *request) override {
+            if (!(method & request->method())) return false;
+            return request->url() == uri || request->url().startsWith(uri + "/");
+        }
+        void handleRequest(AsyncWebServerRequest *request) override { if (onRequest) onRequest(request); }
+        void handleUpload(AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final) override {
+            if (onUpload) onUpload(request, filename, index, data, len, final);
+        }
+        void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override {
+            if (onBody) onBody(request, data, len, index, total);
+        }
+};
+
+// Keeps what was sent, instead of streaming it to connected clients
+class AsyncEventSource : public AsyncWebHandler {
+    public:
+        AsyncEventSource(const String &url) : url(url) {}
+        bool canHandle(AsyncWebServerRequest *request) override {
+            return request->method() == HTTP_GET && request->url() == url;
+        }
+        void handleRequest(AsyncWebServerRequest *request) override {
+            clients++;
+            request->send(200, "text/event-stream");
+        }
+        size_t count() const { return clients; }
+        void send(const char *message, const char *event = nullptr, uint32_t id = 0, uint32_t reconnect = 0) {
+            (void)id; (void)reconnect;
+            sent.push_back({event ? event : "", message});
+        }
+
+        // Host-only
+        String url;
+        size_t clients = 0;
+        std::vector<std::pair<String, String>> sent;
+};
+
+class AsyncWebServer {
+    public:
+        AsyncWebServer(uint16_t port) : port(port) {}
+        // Owns its handlers, like the real server
+        ~AsyncWebServer() {
+            for (auto *h : handlers) delete h;
+            for (auto *h : external) delete h;
+        }
+        void begin() { begun = true; }
+        void end() { begun = false; }
+        AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest) {
+            return on(uri, method, onRequest, nullptr, nullptr);
+        }
+        AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody = nullptr) {
+            auto *h = new AsyncCallbackWebHandler();
+            h->uri = uri;
+            h->method = method;
+            h->onRequest = onRequest;
+            h->onUpload = onUpload;
+            h->onBody = onBody;
+            handlers.push_back(h);
+            return *h;
+        }
+        AsyncWebHandler &addHandler(AsyncWebHandler *handler) {
+            external.push_back(handler);
+            return *handler;
+        }
+        bool removeHandler(AsyncWebHandler *handler) {
+            for (auto it = handlers.begin(); it != handlers.end(); ++it) {
+                if (*it == handler) { handlers.erase(it); delete handler; return true; }
+            }
+            for (auto it = external.begin(); it != external.end(); ++it) {
+                if (*it == handler) { external.erase(it); delete handler; return true; }
+            }
+            return false;
+        }
+        void onNotFound(ArRequestHandlerFunction fn) { notFound = fn; }
+
+        // Host-only: route a synthetic request like the real server would.
+        void dispatch(AsyncWebServerRequest *request) {
+            for (auto *h : handlers) {
+                if (h->canHandle(request)) { h->handleRequest(request); return; }
+            }
+            for (auto *h : external) {
+                if (h->canHandle(request)) { h->handleRequest(request); return; }
+            }
+            if (notFound) notFound(request);
+        }
+        AsyncWebHandler *find(AsyncWebServerRequest *request) {
+            for (auto *h : handlers) if (h->canHandle(request)) return h;
+            for (auto *h : external) if (h->canHandle(request)) return h;
+            return nullptr;
+        }
+
+        uint16_t port;
+        bool begun = false;
+
+    private:
+        std::vector<AsyncCallbackWebHandler *> handlers;
+        std::vector<AsyncWebHandler *> external;
+        ArRequestHandlerFunction notFound;
+};
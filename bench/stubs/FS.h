@@ -0,0 +1,89 @@
+// Host stand-in for the Arduino FS layer: a flat, in-memory file system.
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "Arduino.h"
+
+namespace fs {
+
+    struct Node {
+        std::string data;
+    };
+
+    class File : public Print {
+        public:
+            File() {}
+            File(std::shared_ptr<Node> node, bool writable) : node(node), writable(writable) {}
+
+            operator bool() const { return node != nullptr; }
+            size_t write(uint8_t c) override { return write(&c, 1); }
+            size_t write(const uint8_t *buf, size_t size) override {
+                if (!node || !writable) return 0;
+                node->data.append((const char *)buf, size);
+                return size;
+            }
+            using Print::write;
+            int available() { return node ? (int)(node->data.size() - pos) : 0; }
+            int read() { return available() > 0 ? (uint8_t)node->data[pos++] : -1; }
+            size_t read(uint8_t *buf, size_t size) {
+                size_t n = std::min(size, (size_t)available());
+                if (n) memcpy(buf, node->data.data() + pos, n);
+                pos += n;
+                return n;
+            }
+            bool seek(uint32_t p) {
+                if (!node || p > node->data.size()) return false;
+                pos = p;
+                return true;
+            }
+            size_t size() const { return node ? node->data.size() : 0; }
+            String readString() {
+                if (!node) return String();
+                String r(node->data.data() + pos, (unsigned int)(node->data.size() - pos));
+                pos = node->data.size();
+                return r;
+            }
+            void close() { node.reset(); }
+
+        private:
+            std::shared_ptr<Node> node;
+            bool writable = false;
+            size_t pos = 0;
+    };
+
+    class FS {
+        public:
+            File open(const String &path, const char *mode = "r") {
+                auto it = files.find(path.c_str());
+                if (mode[0] == 'r') {
+                    if (it == files.end()) return File();
+                    return File(it->second, false);
+                }
+                if (it == files.end() || mode[0] == 'w') {
+                    auto node = std::make_shared<Node>();
+                    files[path.c_str()] = node;
+                    return File(node, true);
+                }
+                return File(it->second, true);
+            }
+            bool exists(const String &path) { return files.count(path.c_str()) > 0; }
+            bool remove(const String &path) { return files.erase(path.c_str()) > 0; }
+            bool rename(const String &from, const String &to) {
+                auto it = files.find(from.c_str());
+                if (it == files.end()) return false;
+                files[to.c_str()] = it->second;
+                files.erase(it);
+                return true;
+            }
+            bool format() { files.clear(); return true; }
+
+        private:
+            std::map<std::string, std::shared_ptr<Node>> files;
+    };
+
+} // namespace fs
+
+using fs::File;
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "WString.h"
+
+class IPAddress {
+    public:
+        IPAddress() {}
+        IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : o{a, b, c, d} {}
+        String toString() const {
+            char buf[16];
+            snprintf(buf, sizeof(buf), "%u.%u.%u.%u", o[0], o[1], o[2], o[3]);
+            return String(buf);
+        }
+        bool operator==(const IPAddress &x) const { return memcmp(o, x.o, 4) == 0; }
+
+    private:
+        uint8_t o[4] = {0, 0, 0, 0};
+};
@@ -0,0 +1,10 @@
+#pragma once
+
+#include "FS.h"
+
+class LittleFSFS : public fs::FS {
+    public:
+        bool begin(bool formatOnFail = false) { (void)formatOnFail; return true; }
+        void end() {}
+};
+extern LittleFSFS LittleFS;
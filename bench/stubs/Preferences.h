@@ -0,0 +1,46 @@
+// Host stand-in for the ESP32 Preferences (NVS) library, kept in memory.
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "Arduino.h"
+
+class Preferences {
+    public:
+        bool begin(const char *name, bool readOnly = false) { (void)readOnly; ns = name; return true; }
+        void end() {}
+        bool clear() { store().clear(); return true; }
+        bool remove(const char *key) { return store().erase(key) > 0; }
+        bool isKey(const char *key) { return store().count(key) > 0; }
+        size_t putString(const char *key, const String &value) {
+            store()[key] = std::string(value.c_str(), value.length());
+            return value.length();
+        }
+        String getString(const char *key, const String &defaultValue = String()) {
+            auto it = store().find(key);
+            return it == store().end() ? defaultValue : String(it->second.data(), (unsigned int)it->second.size());
+        }
+        size_t putBytes(const char *key, const void *value, size_t len) {
+            store()[key] = std::string((const char *)value, len);
+            return len;
+        }
+        size_t getBytesLength(const char *key) {
+            auto it = store().find(key);
+            return it == store().end() ? 0 : it->second.size();
+        }
+        size_t getBytes(const char *key, void *buf, size_t maxLen) {
+            auto it = store().find(key);
+            if (it == store().end()) return 0;
+            size_t n = std::min(maxLen, it->second.size());
+            memcpy(buf, it->second.data(), n);
+            return n;
+        }
+
+    private:
+        std::string ns;
+        std::map<std::string, std::string> &store() {
+            static std::map<std::string, std::map<std::string, std::string>> all;
+            return all[ns];
+        }
+};
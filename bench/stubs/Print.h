@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdarg.h>
+#include <stdio.h>
+
+#include "WString.h"
+
+#define DEC 10
+#define HEX 16
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t c) = 0;
+        virtual size_t write(const uint8_t *buffer, size_t size) {
+            size_t n = 0;
+            while (size--) n += write(*buffer++);
+            return n;
+        }
+        size_t write(const char *s) { return s ? write((const uint8_t *)s, strlen(s)) : 0; }
+        size_t write(const char *s, size_t n) { return write((const uint8_t *)s, n); }
+
+        size_t print(const char *s) { return write(s); }
+        size_t print(const String &s) { return write(s.c_str(), s.length()); }
+        size_t print(const __FlashStringHelper *f) { return write(reinterpret_cast<const char *>(f)); }
+        size_t print(char c) { return write((uint8_t)c); }
+        size_t print(int v, int base = DEC) { return print(String(v, (unsigned char)base)); }
+        size_t print(unsigned int v, int base = DEC) { return print(String(v, (unsigned char)base)); }
+        size_t print(long v, int base = DEC) { return print(String(v, (unsigned char)base)); }
+        size_t print(unsigned long v, int base = DEC) { return print(String(v, (unsigned char)base)); }
+        size_t print(double v, int decimals = 2) { return print(String(v, (unsigned int)decimals)); }
+        template <typename T> size_t println(const T &v) { return print(v) + println(); }
+        template <typename T> size_t println(const T &v, int base) { return print(v, base) + println(); }
+        size_t println() { return write("\r\n"); }
+        size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3))) {
+            char buf[256];
+            va_list ap;
+            va_start(ap, format);
+            int n = vsnprintf(buf, sizeof(buf), format, ap);
+            va_end(ap);
+            if (n < 0) return 0;
+            return write((const uint8_t *)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+        }
+};
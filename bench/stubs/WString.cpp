@@ -0,0 +1,124 @@
+#include "WString.h"
+
+#include <stdio.h>
+#include <ctype.h>
+
+bool String::reserve(unsigned int size) {
+    if (buf && cap >= size) return true;
+    char *n = (char *)realloc(buf, size + 1);
+    if (!n) return false;
+    if (!buf) n[0] = 0;
+    buf = n;
+    cap = size;
+    return true;
+}
+
+void String::copy(const char *c, unsigned int n) {
+    if (!reserve(n)) return;
+    if (n) memmove(buf, c, n);
+    buf[n] = 0;
+    len = n;
+}
+
+bool String::concat(const char *c, unsigned int n) {
+    if (!n) return true;
+    unsigned int want = len + n;
+    if (want > cap && !reserve(want > cap * 2 ? want : cap * 2)) return false;
+    memmove(buf + len, c, n);
+    len = want;
+    buf[len] = 0;
+    return true;
+}
+
+void String::fromLong(long v, unsigned char base) {
+    if (v < 0 && base == 10) {
+        fromULong((unsigned long)-v, base);
+        String r("-");
+        r.concat(*this);
+        *this = static_cast<String &&>(r);
+    } else {
+        fromULong((unsigned long)v, base);
+    }
+}
+
+void String::fromULong(unsigned long v, unsigned char base) {
+    char tmp[sizeof(unsigned long) * 8 + 1];
+    char *p = tmp + sizeof(tmp) - 1;
+    *p = 0;
+    do {
+        unsigned d = v % base;
+        *--p = d < 10 ? '0' + d : 'a' + d - 10;
+        v /= base;
+    } while (v);
+    copy(p, strlen(p));
+}
+
+void String::fromDouble(double v, unsigned int decimals) {
+    char tmp[64];
+    snprintf(tmp, sizeof(tmp), "%.*f", decimals, v);
+    copy(tmp, strlen(tmp));
+}
+
+int String::indexOf(char c, unsigned int from) const {
+    if (from >= len) return -1;
+    const char *p = strchr(buf + from, c);
+    return p ? (int)(p - buf) : -1;
+}
+
+int String::indexOf(const String &s, unsigned int from) const {
+    if (from >= len) return -1;
+    const char *p = strstr(buf + from, s.c_str());
+    return p ? (int)(p - buf) : -1;
+}
+
+int String::lastIndexOf(char c) const {
+    if (!len) return -1;
+    const char *p = strrchr(buf, c);
+    return p ? (int)(p - buf) : -1;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) { unsigned int t = from; from = to; to = t; }
+    if (from >= len) return String();
+    if (to > len) to = len;
+    return String(buf + from, to - from);
+}
+
+void String::replace(const String &find, const String &with) {
+    if (!len || !find.len) return;
+    String r;
+    unsigned int i = 0;
+    bool found = false;
+    for (;;) {
+        const char *p = strstr(buf + i, find.c_str());
+        if (!p) break;
+        found = true;
+        r.concat(buf + i, (unsigned int)(p - buf) - i);
+        r.concat(with);
+        i = (unsigned int)(p - buf) + find.len;
+    }
+    if (!found) return;
+    r.concat(buf + i, len - i);
+    *this = static_cast<String &&>(r);
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index >= len) return;
+    if (count > len - index) count = len - index;
+    memmove(buf + index, buf + index + count, len - index - count + 1);
+    len -= count;
+}
+
+void String::trim() {
+    if (!len) return;
+    unsigned int b = 0, e = len;
+    while (b < e && isspace((unsigned char)buf[b])) b++;
+    while (e > b && isspace((unsigned char)buf[e - 1])) e--;
+    len = e - b;
+    memmove(buf, buf + b, len);
+    buf[len] = 0;
+}
+
+void String::toLowerCase() {
+    for (unsigned int i = 0; i < len; i++) buf[i] = (char)tolower((unsigned char)buf[i]);
+}
@@ -0,0 +1,111 @@
+// Host stand-in for the Arduino String class. Only the subset used by
+// AsyncWiFiSettings is implemented. All storage goes through malloc/realloc
+// so the benchmark can count allocations.
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
+#define PROGMEM
+#define PSTR(s) (s)
+
+class String {
+        typedef void (String::*StringIfHelperType)() const;
+        void StringIfHelper() const {}
+
+    public:
+        String(const char *cstr = "") { copy(cstr, cstr ? strlen(cstr) : 0); }
+        String(const char *cstr, unsigned int len) { copy(cstr, len); }
+        String(const __FlashStringHelper *f) : String(reinterpret_cast<const char *>(f)) {}
+        String(const String &s) { copy(s.buf, s.len); }
+        String(String &&s) noexcept : buf(s.buf), len(s.len), cap(s.cap) { s.buf = nullptr; s.len = s.cap = 0; }
+        explicit String(char c) { char b[2] = {c, 0}; copy(b, 1); }
+        String(int v, unsigned char base = 10) { fromLong(v, base); }
+        String(unsigned int v, unsigned char base = 10) { fromULong(v, base); }
+        String(long v, unsigned char base = 10) { fromLong(v, base); }
+        String(unsigned long v, unsigned char base = 10) { fromULong(v, base); }
+        String(float v, unsigned int decimals = 2) { fromDouble(v, decimals); }
+        String(double v, unsigned int decimals = 2) { fromDouble(v, decimals); }
+        ~String() { free(buf); }
+
+        String &operator=(const String &s) { if (this != &s) copy(s.buf, s.len); return *this; }
+        String &operator=(String &&s) noexcept {
+            if (this != &s) { free(buf); buf = s.buf; len = s.len; cap = s.cap; s.buf = nullptr; s.len = s.cap = 0; }
+            return *this;
+        }
+        String &operator=(const char *c) { copy(c, c ? strlen(c) : 0); return *this; }
+        String &operator=(const __FlashStringHelper *f) { return *this = reinterpret_cast<const char *>(f); }
+
+        bool reserve(unsigned int size);
+        unsigned int length() const { return len; }
+        bool isEmpty() const { return len == 0; }
+        const char *c_str() const { return buf ? buf : ""; }
+        operator StringIfHelperType() const { return buf ? &String::StringIfHelper : 0; }
+
+        bool concat(const char *c, unsigned int n);
+        bool concat(const char *c) { return c ? concat(c, strlen(c)) : false; }
+        bool concat(const String &s) { return concat(s.c_str(), s.len); }
+        bool concat(const __FlashStringHelper *f) { return concat(reinterpret_cast<const char *>(f)); }
+        bool concat(char c) { return concat(&c, 1); }
+        bool concat(int v) { return concat(String(v)); }
+        bool concat(unsigned int v) { return concat(String(v)); }
+        bool concat(long v) { return concat(String(v)); }
+        bool concat(unsigned long v) { return concat(String(v)); }
+        bool concat(float v) { return concat(String(v)); }
+        template <typename T> String &operator+=(const T &v) { concat(v); return *this; }
+
+        int compareTo(const String &s) const { return strcmp(c_str(), s.c_str()); }
+        bool equals(const String &s) const { return len == s.len && compareTo(s) == 0; }
+        bool equals(const char *c) const { return strcmp(c_str(), c ? c : "") == 0; }
+        bool operator==(const String &s) const { return equals(s); }
+        bool operator==(const char *c) const { return equals(c); }
+        bool operator!=(const String &s) const { return !equals(s); }
+        bool operator!=(const char *c) const { return !equals(c); }
+        bool operator<(const String &s) const { return compareTo(s) < 0; }
+        bool startsWith(const String &s) const { return s.len <= len && strncmp(c_str(), s.c_str(), s.len) == 0; }
+        bool endsWith(const String &s) const { return s.len <= len && strcmp(c_str() + len - s.len, s.c_str()) == 0; }
+
+        char charAt(unsigned int i) const { return i < len ? buf[i] : 0; }
+        char operator[](unsigned int i) const { return charAt(i); }
+        char &operator[](unsigned int i) { return buf[i]; }
+        int indexOf(char c, unsigned int from = 0) const;
+        int indexOf(const String &s, unsigned int from = 0) const;
+        int lastIndexOf(char c) const;
+        String substring(unsigned int from) const { return substring(from, len); }
+        String substring(unsigned int from, unsigned int to) const;
+
+        void replace(const String &find, const String &replace);
+        void remove(unsigned int index, unsigned int count = (unsigned int)-1);
+        void trim();
+        void toLowerCase();
+        long toInt() const { return buf ? atol(buf) : 0; }
+        float toFloat() const { return buf ? (float)atof(buf) : 0; }
+
+    private:
+        char *buf = nullptr;
+        unsigned int len = 0;
+        unsigned int cap = 0;
+
+        void copy(const char *c, unsigned int n);
+        void fromLong(long v, unsigned char base);
+        void fromULong(unsigned long v, unsigned char base);
+        void fromDouble(double v, unsigned int decimals);
+};
+
+class StringSumHelper : public String {
+    public:
+        StringSumHelper(const String &s) : String(s) {}
+        StringSumHelper(const char *c) : String(c) {}
+};
+
+inline StringSumHelper operator+(const String &a, const String &b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const String &a, const char *b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const char *a, const String &b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const String &a, char b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const String &a, const __FlashStringHelper *b) { StringSumHelper r(a); r.concat(b); return r; }
+inline StringSumHelper operator+(const __FlashStringHelper *a, const String &b) { StringSumHelper r(reinterpret_cast<const char *>(a)); r.concat(b); return r; }
+inline bool operator==(const char *a, const String &b) { return b == a; }
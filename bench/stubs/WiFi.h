@@ -0,0 +1,75 @@
+// Host stand-in for the ESP32 WiFi library. Scan results and connection
+// outcome are scripted through the extra setters at the bottom.
+#pragma once
+
+#include <functional>
+
+#include "Arduino.h"
+#include "esp_wifi.h"
+
+typedef enum { WIFI_OFF = 0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL,
+    WL_SCAN_COMPLETED,
+    WL_CONNECTED,
+    WL_CONNECT_FAILED,
+    WL_CONNECTION_LOST,
+    WL_DISCONNECTED,
+} wl_status_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_SCAN_DONE = 1,
+    ARDUINO_EVENT_WIFI_STA_START,
+    ARDUINO_EVENT_WIFI_STA_CONNECTED,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP,
+} arduino_event_id_t;
+typedef struct { int reserved; } arduino_event_info_t;
+typedef int wifi_event_id_t;
+typedef std::function<void(arduino_event_id_t, arduino_event_info_t)> WiFiEventFuncCb;
+
+class WiFiClass {
+    public:
+        wifi_mode_t getMode() { return mode_; }
+        bool mode(wifi_mode_t m) { mode_ = m; return true; }
+        bool disconnect(bool wifioff = false, bool eraseap = false) { (void)eraseap; if (wifioff) mode_ = WIFI_OFF; status_ = WL_DISCONNECTED; return true; }
+        void persistent(bool) {}
+        bool setAutoReconnect(bool) { return true; }
+        bool setHostname(const char *) { return true; }
+        bool softAP(const char *, const char * = nullptr) { mode_ = WIFI_AP; return true; }
+        IPAddress softAPIP() { return IPAddress(192, 168, 4, 1); }
+        IPAddress localIP() { return IPAddress(10, 0, 0, 2); }
+        wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+        wl_status_t status();
+        int16_t scanNetworks(bool async = false);
+        int16_t scanComplete() { return scanCount; }
+        void scanDelete() {}
+        String SSID(uint8_t i) { return i < ssids.size() ? ssids[i] : String(); }
+        wifi_auth_mode_t encryptionType(uint8_t i) { return i < ssids.size() ? (i % 3 ? WIFI_AUTH_WPA2_PSK : WIFI_AUTH_OPEN) : WIFI_AUTH_OPEN; }
+        wifi_event_id_t onEvent(WiFiEventFuncCb cb, arduino_event_id_t event) {
+            handlers.push_back({event, cb});
+            return (wifi_event_id_t)handlers.size();
+        }
+        void removeEvent(wifi_event_id_t id) {
+            if (id > 0 && (size_t)id <= handlers.size()) handlers[id - 1].second = nullptr;
+        }
+
+        // Host-only scripting
+        std::vector<String> ssids;
+        unsigned long connectDelayMs = 0;
+        void emit(arduino_event_id_t event) {
+            for (auto &h : handlers) if (h.first == event && h.second) h.second(event, arduino_event_info_t());
+        }
+
+    private:
+        wifi_mode_t mode_ = WIFI_OFF;
+        wl_status_t status_ = WL_DISCONNECTED;
+        unsigned long beganAt = 0;
+        int16_t scanCount = -2;
+        std::vector<std::pair<arduino_event_id_t, WiFiEventFuncCb>> handlers;
+};
+extern WiFiClass &WiFi;
@@ -0,0 +1,2 @@
+#pragma once
+inline int esp_task_wdt_reset() { return 0; }
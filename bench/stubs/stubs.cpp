@@ -0,0 +1,72 @@
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "SPIFFS.h"
+#include "WiFi.h"
+
+namespace {
+    const auto epoch = std::chrono::steady_clock::now();
+    std::mt19937 rng(42);
+    bool serialEnabled = getenv("NATIVE_SERIAL") != nullptr;
+}
+
+unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+unsigned long micros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+void yield() {}
+long random(long max) { return max > 0 ? (long)(rng() % (unsigned long)max) : 0; }
+long random(long min, long max) { return min + random(max - min); }
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+    if (serialEnabled) fwrite(buffer, 1, size, stderr);
+    return size;
+}
+
+HardwareSerial Serial;
+EspClass ESP;
+SPIFFSFS SPIFFS;
+LittleFSFS LittleFS;
+// Never destroyed, like on the device, so instances can unregister their
+// events during static destruction.
+WiFiClass &WiFi = *new WiFiClass();
+
+uint32_t __attribute__((weak)) native_free_heap() { return 320 * 1024; }
+uint32_t __attribute__((weak)) native_min_free_heap() { return 320 * 1024; }
+uint32_t EspClass::getFreeHeap() { return native_free_heap(); }
+uint32_t EspClass::getMinFreeHeap() { return native_min_free_heap(); }
+void EspClass::restart() { exit(0); }
+
+wl_status_t WiFiClass::begin(const char *, const char *) {
+    mode_ = WIFI_STA;
+    beganAt = millis();
+    status_ = WL_DISCONNECTED;
+    return status();
+}
+
+wl_status_t WiFiClass::status() {
+    if (mode_ == WIFI_STA && status_ != WL_CONNECTED && millis() - beganAt >= connectDelayMs) {
+        status_ = WL_CONNECTED;
+        emit(ARDUINO_EVENT_WIFI_STA_CONNECTED);
+        emit(ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    }
+    return status_;
+}
+
+int16_t WiFiClass::scanNetworks(bool async) {
+    scanCount = (int16_t)ssids.size();
+    if (async) emit(ARDUINO_EVENT_WIFI_SCAN_DONE);
+    return scanCount;
+}
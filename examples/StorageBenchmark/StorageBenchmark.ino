@@ -0,0 +1,81 @@
+/*
+    AsyncWiFiSettings storage benchmark
+
+    Compares the storage backends by how long it takes to load NUM_KEYS
+    values (like .string() and friends do at boot) and to save them (like
+    the portal does).
+
+    Source and further documentation available at
+    https://github.com/ESPresense/AsyncWiFiSettings
+
+    Note: this example is written for ESP32. SPIFFS and LittleFS share the
+    same flash partition, so running this sketch reformats it. It also
+    removes the keys it wrote from NVS afterwards.
+*/
+
+#include <LittleFS.h>
+#include <SPIFFS.h>
+#include <AsyncWiFiSettings.h>
+
+#ifndef NUM_KEYS
+#define NUM_KEYS 50
+#endif
+
+String key(int i) {
+    return "bench_key_" + String(i);
+}
+
+void bench(const char* name, AsyncWiFiSettingsStorage& storage) {
+    unsigned long start = micros();
+    for (int i = 0; i < NUM_KEYS; i++) {
+        storage.write(key(i), "value of setting number " + String(i));
+    }
+    unsigned long save = micros() - start;
+
+    start = micros();
+    size_t bytes = 0;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        bytes += storage.read(key(i)).length();
+    }
+    unsigned long load = micros() - start;
+
+    // Unset keys are what most parameters look like on a fresh device
+    start = micros();
+    for (int i = 0; i < NUM_KEYS; i++) {
+        storage.read("bench_missing_" + String(i));
+    }
+    unsigned long miss = micros() - start;
+
+    for (int i = 0; i < NUM_KEYS; i++) {
+        storage.write(key(i), "");
+    }
+
+    Serial.printf(
+        "%-8s keys=%d load=%luus (%luus/key, %u bytes) missing=%luus save=%luus (%luus/key)\n",
+        name, NUM_KEYS, load, load / NUM_KEYS, (unsigned int)bytes, miss, save, save / NUM_KEYS);
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    AsyncWiFiSettingsRAMStorage ram;
+    bench("RAM", ram);
+
+    AsyncWiFiSettingsNVSStorage nvs("wsbench");
+    bench("NVS", nvs);
+
+    if (SPIFFS.begin(true)) {
+        AsyncWiFiSettingsFSStorage spiffs(SPIFFS);
+        bench("SPIFFS", spiffs);
+        SPIFFS.end();
+    }
+
+    if (LittleFS.begin(true)) {
+        AsyncWiFiSettingsFSStorage littlefs(LittleFS);
+        bench("LittleFS", littlefs);
+        LittleFS.end();
+    }
+}
+
+void loop() {
+}
@@ -1,6 +1,5 @@
 #include "AsyncWiFiSettings.h"
 
-#define ESPFS SPIFFS
 #define ESPMAC (Sprintf("%06" PRIx32, ((uint32_t)(ESP.getEfuseMac() >> 24))))
 
 #include <DNSServer.h>
@@ -11,31 +10,23 @@
 #include <esp_wifi.h>
 #include <limits.h>
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 #include "AsyncWiFiSettings_strings.h"
 
-AsyncWiFiSettingsLanguage::Texts _WSL_T;
-
 #define Sprintf(f, ...) ({ char* s; asprintf(&s, f, __VA_ARGS__); String r = s; free(s); r; })
 
-namespace { // Helpers
-    String slurp(const String &fn) {
-        File f = ESPFS.open(fn, "r");
-        String r = f.readString();
-        f.close();
-        return r;
-    }
+// Keeps the escaped markup around each value in memory, so a page view only
+// escapes the values. Build with -DASYNCWIFISETTINGS_HTML_CACHE=0 to save the
+// RAM instead.
+#ifndef ASYNCWIFISETTINGS_HTML_CACHE
+#define ASYNCWIFISETTINGS_HTML_CACHE 1
+#endif
 
-    bool spurt(const String &fn, const String &content) {
-        if (content.isEmpty())
-            return ESPFS.exists(fn) ? ESPFS.remove(fn) : true;
-        File f = ESPFS.open(fn, "w");
-        if (!f) return false;
-        auto w = f.print(content);
-        f.close();
-        return w == content.length();
-    }
+namespace { // Helpers
+    AsyncWiFiSettingsFSStorage spiffs(SPIFFS);
 
     String pwgen() {
         const char *passchars = "ABCEFGHJKLMNPRSTUXYZabcdefhkmnorstvxz23456789-#@?!";
@@ -69,6 +60,15 @@ namespace { // Helpers
         return r;
     }
 
+    uint32_t crc32(uint32_t crc, const uint8_t *buf, size_t len) {
+        crc = ~crc;
+        while (len--) {
+            crc ^= *buf++;
+            for (int k = 0; k < 8; k++) crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+        }
+        return ~crc;
+    }
+
     String json_encode(const String &raw) {
         String r;
         for (unsigned int i = 0; i < raw.length(); i++) {
@@ -92,29 +92,124 @@ namespace { // Helpers
         return r;
     }
 
-    struct AsyncWiFiSettingsParameter {
-        String name;
-        String label;
-        String value;
-        String init;
-        long min = LONG_MIN;
-        long max = LONG_MAX;
+    // Forms submitted by the portal script expect no redirect
+    bool fetched(AsyncWebServerRequest *request) {
+        return request->hasHeader("X-Requested-With");
+    }
 
-        String filename() {
-            String fn = "/";
-            fn += name;
-            return fn;
+    // Collects the output of render() where a String is needed
+    struct StringPrint : Print {
+        String s;
+        size_t write(uint8_t c) { s += (char)c; return 1; }
+        size_t write(const uint8_t *buf, size_t size) {
+            s.concat((const char *)buf, size);
+            return size;
         }
+    };
+
+    // Passes output on, counting the bytes for metrics
+    struct CountingPrint : Print {
+        Print &out;
+        size_t bytes = 0;
+
+        CountingPrint(Print &out) : out(out) {}
+
+        size_t write(uint8_t c) { return count(out.write(c)); }
+        size_t write(const uint8_t *buf, size_t size) { return count(out.write(buf, size)); }
+
+        size_t count(size_t n) {
+#if ASYNCWIFISETTINGS_METRICS
+            bytes += n;
+#endif
+            return n;
+        }
+    };
+
+    struct AsyncWiFiSettingsBlob;
+} // namespace
 
-        bool store() { return (name && name.length()) ? spurt(filename(), value) : true; }
+struct AsyncWiFiSettingsParameter {
+    AsyncWiFiSettingsClass *owner = nullptr;
+    String name;
+    String label;
+    String value;
+    String init;
+    long min = LONG_MIN;
+    long max = LONG_MAX;
+    const char *const AsyncWiFiSettingsLanguage::Texts::*text = nullptr; // label, if built-in
 
-        void fill() { if (name && name.length()) value = slurp(filename()); }
+    String effective() { return value.length() ? value : init; }
 
-        virtual void set(const String &) = 0;
+    virtual ~AsyncWiFiSettingsParameter() {}
 
-        virtual String html() = 0;
+    virtual bool store() { return (name && name.length()) ? spurt(name, value) : true; }
 
-        virtual String json() = 0;
+    virtual void fill() { if (name && name.length()) value = slurp(name); }
+
+    virtual void set(const String &) = 0;
+
+    virtual String html() = 0;
+
+    virtual void render(Print &out) { out.print(html()); }
+
+    virtual String json() = 0;
+
+    // HTML that can't be nested in the main form
+    virtual String form() { return ""; }
+
+    // No RTTI on this platform
+    virtual AsyncWiFiSettingsBlob *blob() { return nullptr; }
+
+    // Never sent to the browser
+    virtual bool secret() { return false; }
+
+    // Called when labels or texts have changed
+    virtual void invalidate() {}
+
+    // Access to the owning instance, for the types below
+    String slurp(const String &key) { return owner->slurp(key); }
+    bool spurt(const String &key, const String &content) { return owner->spurt(key, content); }
+    const AsyncWiFiSettingsLanguage::Texts *texts() { return owner->texts; }
+    String url(const String &path) { return owner->base + path; }
+};
+
+namespace {
+
+    // A parameter whose markup depends on its value in one place only.
+    // Everything around it is escaped once, on the first render after
+    // registration or a language change.
+    struct AsyncWiFiSettingsField : AsyncWiFiSettingsParameter {
+        // The markup, with v in place of valueHtml()
+        virtual String markup(const String &v) = 0;
+
+        virtual String valueHtml() { return html_entities(value); }
+
+        String html() { return markup(valueHtml()); }
+
+#if ASYNCWIFISETTINGS_HTML_CACHE
+        String before;
+        String after;
+        bool cached = false;
+
+        void render(Print &out) {
+            if (!cached) {
+                // Escaped text never contains control characters
+                String h = markup("\x01");
+                int i = h.indexOf('\x01');
+                before = i >= 0 ? h.substring(0, i) : h;
+                after = i >= 0 ? h.substring(i + 1) : String();
+                cached = true;
+            }
+            out.print(before);
+            out.print(valueHtml());
+            out.print(after);
+        }
+
+        void invalidate() {
+            before = after = String();
+            cached = false;
+        }
+#endif
     };
 
     struct AsyncWiFiSettingsDropdown : AsyncWiFiSettingsParameter {
@@ -164,9 +259,21 @@ namespace { // Helpers
         }
     };
 
-    struct AsyncWiFiSettingsString : AsyncWiFiSettingsParameter {
+    struct AsyncWiFiSettingsFlashDropdown : AsyncWiFiSettingsParameter {
+        // Options come from a table in flash or from a callback, and are
+        // streamed out one by one without being copied.
+
+        const char *const *table = nullptr;
+        size_t count = 0;
+        AsyncWiFiSettingsClass::TCallbackOption generator;
+
         virtual void set(const String &v) { value = v; }
 
+        const char *option(size_t i) {
+            if (generator) return generator(i);
+            return i < count ? table[i] : nullptr;
+        }
+
         String json() {
             if (value == "") return "";
             String j = F("\"{name}\":\"{value}\"");
@@ -176,16 +283,66 @@ namespace { // Helpers
         }
 
         String html() {
+            StringPrint h;
+            render(h);
+            return h.s;
+        }
+
+        void render(Print &out) {
+            out.print(F("<p><label>"));
+            out.print(html_entities(label));
+            out.print(F(":<br><select name='"));
+            out.print(html_entities(name));
+            out.print(F("' value='"));
+            out.print(html_entities(value));
+            out.print(F("'>"));
+
+            if (value == "") {
+                const char *o = option(init.toInt());
+                if (o) {
+                    out.print(F("<option value='' disabled selected hidden>"));
+                    out.print(o);
+                    out.print(F("</option>"));
+                }
+            }
+
+            long selected = value.length() ? value.toInt() : -1;
+            const char *o;
+            for (size_t i = 0; (o = option(i)); i++) {
+                out.print(F("<option value='"));
+                out.print((unsigned int)i);
+                out.print((long)i == selected ? F("' selected>") : F("'>"));
+                out.print(o);
+                out.print(F("</option>"));
+            }
+            out.print(F("</select></label>"));
+        }
+    };
+
+    struct AsyncWiFiSettingsString : AsyncWiFiSettingsField {
+        virtual void set(const String &v) { value = v; }
+
+        String json() {
+            if (value == "") return "";
+            String j = F("\"{name}\":\"{value}\"");
+            j.replace("{name}", json_encode(name));
+            j.replace("{value}", json_encode(value));
+            return j;
+        }
+
+        String markup(const String &v) {
             String h = F("<p><label>{label}:<br><input name='{name}' value='{value}' placeholder='{init}'></label>");
             h.replace("{name}", html_entities(name));
-            h.replace("{value}", html_entities(value));
             h.replace("{init}", html_entities(init));
             h.replace("{label}", html_entities(label));
+            h.replace("{value}", v);
             return h;
         }
     };
 
-    struct AsyncWiFiSettingsPassword : AsyncWiFiSettingsParameter {
+    struct AsyncWiFiSettingsPassword : AsyncWiFiSettingsField {
+        bool secret() { return true; }
+
         virtual void set(const String &v) {
             String trimmed = v;
             trimmed.trim();
@@ -196,17 +353,19 @@ namespace { // Helpers
             return "";
         }
 
-        String html() {
+        String valueHtml() { return html_entities(secure(value)); }
+
+        String markup(const String &v) {
             String h = F("<p><label>{label}:<br><input type='password' name='{name}' value='{value}' placeholder='{init}'></label>");
             h.replace("{name}", html_entities(name));
-            h.replace("{value}", html_entities(secure(value)));
             h.replace("{init}", html_entities(init));
             h.replace("{label}", html_entities(label));
+            h.replace("{value}", v);
             return h;
         }
     };
 
-    struct AsyncWiFiSettingsInt : AsyncWiFiSettingsParameter {
+    struct AsyncWiFiSettingsInt : AsyncWiFiSettingsField {
         virtual void set(const String &v) { value = v; }
 
         String json() {
@@ -217,20 +376,20 @@ namespace { // Helpers
             return j;
         }
 
-        String html() {
+        String markup(const String &v) {
             String h = F(
                 "<p><label>{label}:<br><input type=number step=1 min={min} max={max} name='{name}' value='{value}' placeholder='{init}'></label>");
             h.replace("{name}", html_entities(name));
-            h.replace("{value}", html_entities(value));
             h.replace("{init}", html_entities(init));
             h.replace("{label}", html_entities(label));
             h.replace("{min}", String(min));
             h.replace("{max}", String(max));
+            h.replace("{value}", v);
             return h;
         }
     };
 
-    struct AsyncWiFiSettingsFloat : AsyncWiFiSettingsParameter {
+    struct AsyncWiFiSettingsFloat : AsyncWiFiSettingsField {
         virtual void set(const String &v) { value = v; }
 
         String json() {
@@ -241,20 +400,20 @@ namespace { // Helpers
             return j;
         }
 
-        String html() {
+        String markup(const String &v) {
             String h = F(
                 "<p><label>{label}:<br><input type=number step=0.01 min={min} max={max} name='{name}' value='{value}' placeholder='{init}'></label>");
             h.replace("{name}", html_entities(name));
-            h.replace("{value}", html_entities(value));
             h.replace("{init}", html_entities(init));
             h.replace("{label}", html_entities(label));
             h.replace("{min}", String(min));
             h.replace("{max}", String(max));
+            h.replace("{value}", v);
             return h;
         }
     };
 
-    struct AsyncWiFiSettingsBool : AsyncWiFiSettingsParameter {
+    struct AsyncWiFiSettingsBool : AsyncWiFiSettingsField {
         virtual void set(const String &v) { value = v.length() ? "1" : "0"; }
 
         String json() {
@@ -265,19 +424,89 @@ namespace { // Helpers
             return j;
         }
 
-        String html() {
+        String valueHtml() { return value.toInt() ? " checked" : ""; }
+
+        String markup(const String &v) {
             String h = F(
                 "<p><label class=c><input type=checkbox name='{name}' value=1{checked}> {label} ({default}: {init})</label>");
             h.replace("{name}", html_entities(name));
-            h.replace("{default}", _WSL_T.init);
-            h.replace("{checked}", value.toInt() ? " checked" : "");
+            h.replace("{default}", texts()->init);
             h.replace("{init}", init.toInt() ? "&#x2611;" : "&#x2610;");
             h.replace("{label}", html_entities(label));
+            h.replace("{checked}", v);
             return h;
         }
     };
 
-    struct AsyncWiFiSettingsHTML : AsyncWiFiSettingsParameter {
+    struct AsyncWiFiSettingsBlob : AsyncWiFiSettingsField {
+        // Large value that never leaves storage as a whole. It's read and
+        // written in chunks; value is only a short summary of the contents.
+
+        String previous;
+        bool ok = true;
+        AsyncWebServerRequest *uploader = nullptr; // owns the staged upload
+
+        AsyncWiFiSettingsBlob *blob() { return this; }
+
+        virtual void set(const String &v) { (void)v; }
+
+        bool store() { return true; }
+
+        void fill() {
+            uint8_t buf[ASYNCWIFISETTINGS_CHUNK_SIZE];
+            size_t size = 0, n;
+            uint32_t crc = 0;
+            while ((n = owner->storage->readChunk(name, size, buf, sizeof(buf)))) {
+                crc = crc32(crc, buf, n);
+                size += n;
+            }
+            value = size ? Sprintf("%u B, CRC32 %08x", (unsigned int)size, (unsigned int)crc) : "";
+        }
+
+        // Uploads go here first, so an aborted one leaves the value alone.
+        // Short, because SPIFFS paths are limited to 31 characters.
+        String staging() { return name + "~"; }
+
+        void upload(size_t index, const uint8_t *data, size_t len, bool final) {
+            if (!index) {
+                previous = value;
+                ok = spurt(staging(), "");
+            }
+            if (ok && len) ok = owner->storage->append(staging(), data, len);
+            if (!final) return;
+            if (ok) ok = owner->storage->rename(staging(), name);
+            if (!ok) spurt(staging(), "");
+            fill();
+        }
+
+        String json() {
+            if (value == "") return "";
+            String j = F("\"{name}\":\"{value}\"");
+            j.replace("{name}", json_encode(name));
+            j.replace("{value}", json_encode(value));
+            return j;
+        }
+
+        String markup(const String &v) {
+            String h = F(
+                "<p><label>{label}:<br><input type=file name='{name}' form='b-{name}'></label>"
+                " <input type=submit value='{upload}' form='b-{name}'> {value}");
+            h.replace("{name}", html_entities(name));
+            h.replace("{label}", html_entities(label));
+            h.replace("{upload}", texts()->upload);
+            h.replace("{value}", v);
+            return h;
+        }
+
+        String form() {
+            String h = F("<form id='b-{name}' action='{url}?name={name}' method=post enctype=multipart/form-data></form>");
+            h.replace("{url}", url("/blob"));
+            h.replace("{name}", html_entities(name));
+            return h;
+        }
+    };
+
+    struct AsyncWiFiSettingsHTML : AsyncWiFiSettingsField {
         // Raw HTML, not an actual parameter. The reason for the "if (name)"
         // in store and fill. Abuses several member variables for completely
         // different functionality.
@@ -288,7 +517,9 @@ namespace { // Helpers
             return "";
         }
 
-        String html() {
+        String valueHtml() { return ""; }
+
+        String markup(const String &) {
             int space = value.indexOf(" ");
 
             String h =
@@ -299,37 +530,571 @@ namespace { // Helpers
         }
     };
 
-    bool extra = false;
+} // namespace
+
+std::vector<AsyncWiFiSettingsParameter *> *AsyncWiFiSettingsClass::params() {
+    return extra ? &extras : &primary;
+}
+
+String AsyncWiFiSettingsClass::slurp(const String &key) {
+    AsyncWiFiSettingsStopwatch t;
+    String r = storage->read(key);
+    metrics.read(t.elapsed(), r.length());
+    return r;
+}
+
+bool AsyncWiFiSettingsClass::spurt(const String &key, const String &content) {
+    AsyncWiFiSettingsStopwatch t;
+    bool r = storage->write(key, content);
+    metrics.write(t.elapsed(), content.length());
+    return r;
+}
+
+int AsyncWiFiSettingsClass::scan() {
+    AsyncWiFiSettingsStopwatch t;
+    int n = WiFi.scanNetworks();
+    metrics.scan(t.elapsed(), n);
+    return n;
+}
 
-    struct std::vector<AsyncWiFiSettingsParameter *> primary;
-    struct std::vector<AsyncWiFiSettingsParameter *> extras;
+// The WiFi event task only leaves the duration of a background scan; it is
+// recorded here, on the web server's task, like all other metrics.
+void AsyncWiFiSettingsClass::scanFinished() {
+    if (scanned.exchange(false)) metrics.scan(scanTook, num_networks);
+}
 
-    std::vector<AsyncWiFiSettingsParameter *> *params() {
-        return extra ? &extras : &primary;
+// The options of the SSID drop-down
+void AsyncWiFiSettingsClass::networks(Print &out) {
+    String current = slurp("wifi-ssid");
+    bool found = false;
+    int n = num_networks;
+    for (int i = 0; i < n; i++) {
+        String opt = F("<option value='{ssid}'{sel}>{ssid} {lock} {1x}</option>");
+        String ssid = WiFi.SSID(i);
+        wifi_auth_mode_t mode = WiFi.encryptionType(i);
+
+        opt.replace("{sel}", ssid == current && !found ? " selected" : "");
+        opt.replace("{ssid}", html_entities(ssid));
+        opt.replace("{lock}", mode != WIFI_AUTH_OPEN ? "&#x1f512;" : "");
+        opt.replace("{1x}", mode == WIFI_AUTH_WPA2_ENTERPRISE ? texts->dot1x : "");
+        out.print(opt);
+
+        if (ssid == current) found = true;
+    }
+    if (!found && current.length()) {
+        String opt = F("<option value='{ssid}' selected>{ssid} (&#x26a0; not in range)</option>");
+        opt.replace("{ssid}", html_entities(current));
+        out.print(opt);
     }
+}
+
+void AsyncWiFiSettingsClass::load(AsyncWiFiSettingsParameter *p) {
+    AsyncWiFiSettingsTraceScope t(trace, "fill", p->name.c_str());
+    p->fill();
+}
+
+// headings has the index in primary of every heading; each starts a section
+// that runs up to the next. Section 0 is everything before the first heading,
+// section -1 is the whole portal.
+void AsyncWiFiSettingsClass::section(int n, size_t &first, size_t &last) {
+    first = (n <= 0) ? 0 : headings[n - 1];
+    last = (n < 0 || (size_t) n >= headings.size()) ? primary.size() : headings[n];
+}
+
+// From <base>/section/<n>, or -1 if there is no such section
+int AsyncWiFiSettingsClass::sectionNumber(AsyncWebServerRequest *request) {
+    String url = request->url();
+    int slash = url.lastIndexOf('/');
+    String digits = url.substring(slash + 1);
+    long n = digits.toInt();
+    if (String(n) != digits) return -1; // no signs, leading zeros or junk
+    return (slash == (int) base.length() + 8 && n >= 1 && (size_t) n <= headings.size()) ? n : -1;
+}
+
+// Switches all portal texts, including the labels of built-in parameters.
+// Can update language.
+void AsyncWiFiSettingsClass::selectLanguage(String &language) {
+    auto *selected = &AsyncWiFiSettingsLanguage::languages[AsyncWiFiSettingsLanguage::select(language)].texts;
+    if (selected == texts) return;
+    texts = selected;
+    for (auto &p : primary) {
+        if (p->text) p->label = texts->*(p->text);
+        p->invalidate();
+    }
+    for (auto &p : extras) {
+        if (p->text) p->label = texts->*(p->text);
+        p->invalidate();
+    }
+}
+
+// Read-only view of all effective values, for application tasks that
+// run concurrently with the web server. Each generation is built in the
+// buffer that readers aren't using, after which `seq` is bumped; readers
+// copy out of the active buffer and only retry if a writer has since
+// started overwriting that same buffer. Outgrown buffers are retired
+// instead of freed, so a slow reader never touches released memory.
+//
+// Records are "name\0value\0", back to back.
+
+namespace {
+    struct SnapshotBuffer {
+        char *data;
+        size_t capacity;
+        std::atomic<size_t> used{0};
+    };
+
+    size_t snapshotRecordSize(AsyncWiFiSettingsParameter *p) {
+        if (!p->name || !p->name.length()) return 0;
+        return p->name.length() + 1 + p->effective().length() + 1;
+    }
+
+    size_t snapshotWriteRecord(char *dst, AsyncWiFiSettingsParameter *p) {
+        if (!p->name || !p->name.length()) return 0;
+        String v = p->effective();
+        memcpy(dst, p->name.c_str(), p->name.length() + 1);
+        dst += p->name.length() + 1;
+        memcpy(dst, v.c_str(), v.length() + 1);
+        return p->name.length() + 1 + v.length() + 1;
+    }
+} // namespace
+
+struct AsyncWiFiSettingsClass::Snapshot {
+    std::atomic<uint32_t> seq{0}; // generation << 1 | writing
+    std::atomic<SnapshotBuffer *> buffers[2] = {};
+    std::vector<SnapshotBuffer *> retired;
+    std::mutex writer;
+
+    SnapshotBuffer *reserve(SnapshotBuffer *b, size_t need) {
+        if (b && b->capacity >= need) return b;
+        if (b) retired.push_back(b);
+        auto *n = new SnapshotBuffer();
+        n->capacity = need + need / 2 + 64;
+        n->data = new char[n->capacity];
+        return n;
+    }
+
+    ~Snapshot() {
+        for (auto &b : buffers) retired.push_back(b.load());
+        for (auto *b : retired) {
+            if (b) delete[] b->data;
+            delete b;
+        }
+    }
+};
+
+// Caller holds snapshot->writer
+void AsyncWiFiSettingsClass::snapshotPublishLocked() {
+    size_t need = 0;
+    for (auto &p : primary) need += snapshotRecordSize(p);
+    for (auto &p : extras) need += snapshotRecordSize(p);
+
+    uint32_t s = snapshot->seq.load(std::memory_order_relaxed);
+    int next = ((s >> 1) + 1) & 1;
+    snapshot->seq.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SnapshotBuffer *b = snapshot->reserve(snapshot->buffers[next].load(std::memory_order_relaxed), need);
+    size_t used = 0;
+    for (auto &p : primary) used += snapshotWriteRecord(b->data + used, p);
+    for (auto &p : extras) used += snapshotWriteRecord(b->data + used, p);
+    b->used.store(used, std::memory_order_release);
+    snapshot->buffers[next].store(b, std::memory_order_release);
+
+    snapshot->seq.store(s + 2, std::memory_order_release);
+}
+
+// Publishes all values of a completed save as a single new generation.
+void AsyncWiFiSettingsClass::snapshotPublish() {
+    std::lock_guard<std::mutex> lock(snapshot->writer);
+    snapshotPublishLocked();
+}
+
+// Adds a newly registered parameter to the current generation. Readers
+// never look past `used`, so appending doesn't disturb them.
+void AsyncWiFiSettingsClass::snapshotAppend(AsyncWiFiSettingsParameter *p) {
+    std::lock_guard<std::mutex> lock(snapshot->writer);
+    size_t size = snapshotRecordSize(p);
+    if (!size) return;
+
+    uint32_t s = snapshot->seq.load(std::memory_order_relaxed);
+    SnapshotBuffer *b = snapshot->buffers[(s >> 1) & 1].load(std::memory_order_relaxed);
+    size_t used = b ? b->used.load(std::memory_order_relaxed) : 0;
+    if (!b || used + size > b->capacity) {
+        snapshotPublishLocked();
+        return;
+    }
+    snapshotWriteRecord(b->data + used, p);
+    b->used.store(used + size, std::memory_order_release);
+}
+
+struct AsyncWiFiSettingsClass::Change {
+    String name;
+    String old;
+    String value;
+};
+
+struct AsyncWiFiSettingsClass::Subscription {
+    String name; // or prefix, for groups
+    bool group;
+    TCallbackChange onChange;
+    TCallback onGroupChange;
+};
+
+void AsyncWiFiSettingsClass::recordChange(std::vector<Change> &changes, const String &name, const String &old, const String &value) {
+    if (old != value) changes.push_back({name, old, value});
+}
+
+// Called once per committed save. Group callbacks fire at most once,
+// no matter how many of their keys changed.
+void AsyncWiFiSettingsClass::notify(const std::vector<Change> &changes) {
+    // Open portal pages update their form in place
+    if (events->count()) {
+        for (auto &c : changes) {
+            for (auto &p : primary) {
+                if (p->name != c.name || p->secret()) continue;
+                String j = F("{\"name\":\"{name}\",\"value\":\"{value}\"}");
+                j.replace("{name}", json_encode(p->name));
+                j.replace("{value}", json_encode(p->value));
+                events->send(j.c_str(), "change");
+            }
+        }
+    }
+
+    for (auto &sub : subscriptions) {
+        for (auto &c : changes) {
+            if (sub.group) {
+                if (!c.name.startsWith(sub.name)) continue;
+                sub.onGroupChange();
+                break;
+            }
+            if (c.name == sub.name) sub.onChange(c.name, c.old, c.value);
+        }
+    }
+}
+
+// Backups are text, one "name=value" record per line, with the name and value
+// percent-encoded where needed. The first line has the format version, the
+// last one a CRC32 of everything before it; it has no "=", so no record can
+// be mistaken for it:
+//
+//   AsyncWiFiSettings 1
+//   wifi-ssid=home
+//   motd=Hello,%0Aworld
+//   crc32 1c291ca3
+
+namespace {
+    const char archiveMagic[] = "AsyncWiFiSettings ";
+    const long archiveVersion = 1;
+    const char restoreKey[] = "AsyncWiFiSettings-restore";
+    const char archiveTrailer[] = "crc32 ";
+
+    bool archiveSpecial(uint8_t c) {
+        return c < ' ' || c == '%' || c == '=' || c == 0x7f;
+    }
+
+    int hexDigit(uint8_t c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    struct ArchiveWriter {
+        Print &out;
+        uint32_t crc = 0;
+
+        ArchiveWriter(Print &out) : out(out) {}
+
+        void raw(const uint8_t *buf, size_t len) {
+            crc = crc32(crc, buf, len);
+            out.write(buf, len);
+        }
+
+        void raw(const char *s) { raw((const uint8_t *)s, strlen(s)); }
+
+        void encoded(const uint8_t *buf, size_t len) {
+            size_t start = 0;
+            for (size_t i = 0; i < len; i++) {
+                if (!archiveSpecial(buf[i])) continue;
+                char e[4];
+                snprintf(e, sizeof(e), "%%%02X", buf[i]);
+                raw(buf + start, i - start);
+                raw(e);
+                start = i + 1;
+            }
+            raw(buf + start, len - start);
+        }
+
+        void encoded(const String &s) { encoded((const uint8_t *)s.c_str(), s.length()); }
+
+        void record(const String &name, const String &value) {
+            encoded(name);
+            raw("=");
+            encoded(value);
+            raw("\n");
+        }
+
+        void finish() {
+            char line[16];
+            snprintf(line, sizeof(line), "%s%08x\n", archiveTrailer, (unsigned int)crc);
+            out.print(line);
+        }
+    };
+
+    // Fed one chunk at a time. Values for which onKey returns true are
+    // passed to onData in pieces instead of being collected in memory.
+    struct ArchiveReader {
+        std::function<bool(const String &name)> onKey;
+        std::function<bool(const uint8_t *data, size_t len)> onData;
+        std::function<bool(const String &name, const String &value)> onRecord;
+        bool done = false; // checksum seen and correct
+
+        uint32_t crc = 0;
+        uint32_t lineCrc = 0; // of everything before this line
+        bool header = true;
+        bool inValue = false;
+        bool streamed = false;
+        int escape = 0;
+        uint8_t decoded = 0;
+        String name;
+        String value;
+        uint8_t chunk[ASYNCWIFISETTINGS_CHUNK_SIZE];
+        size_t used = 0;
+
+        bool feed(const uint8_t *buf, size_t len) {
+            for (size_t i = 0; i < len; i++) {
+                if (!feed(buf[i])) return false;
+            }
+            return true;
+        }
+
+        bool feed(uint8_t c) {
+            if (done) return false; // nothing may follow the checksum
+            crc = crc32(crc, &c, 1);
+            if (c == '\n') return endLine();
+            if (c == '\r') return false;
+            if (header) {
+                name += (char)c;
+                return true;
+            }
+            if (c == '=' && !inValue) {
+                if (escape) return false;
+                inValue = true;
+                streamed = onKey(name);
+                return true;
+            }
+
+            if (escape) {
+                int d = hexDigit(c);
+                if (d < 0) return false;
+                decoded = decoded << 4 | d;
+                if (--escape) return true;
+                c = decoded;
+            } else if (c == '%') {
+                escape = 2;
+                decoded = 0;
+                return true;
+            }
+
+            if (!inValue) {
+                name += (char)c;
+            } else if (!streamed) {
+                value += (char)c;
+            } else {
+                chunk[used++] = c;
+                if (used == sizeof(chunk)) {
+                    used = 0;
+                    return onData(chunk, sizeof(chunk));
+                }
+            }
+            return true;
+        }
+
+        bool endLine() {
+            bool ok;
+            if (escape) {
+                ok = false;
+            } else if (header) {
+                ok = name.startsWith(archiveMagic) && name.substring(strlen(archiveMagic)).toInt() == archiveVersion;
+                header = false;
+            } else if (!inValue) {
+                ok = trailer();
+                done = ok;
+            } else {
+                ok = (!used || onData(chunk, used)) && onRecord(name, value);
+            }
+            name = "";
+            value = "";
+            inValue = streamed = false;
+            used = 0;
+            lineCrc = crc;
+            return ok;
+        }
+
+        bool trailer() {
+            size_t prefix = strlen(archiveTrailer);
+            if (name.length() != prefix + 8 || !name.startsWith(archiveTrailer)) return false;
+            uint32_t sum = 0;
+            for (size_t i = prefix; i < name.length(); i++) {
+                int d = hexDigit(name[i]);
+                if (d < 0) return false;
+                sum = sum << 4 | d;
+            }
+            return sum == lineCrc;
+        }
+    };
 } // namespace
 
+void AsyncWiFiSettingsClass::backup(Print &out) {
+    ArchiveWriter w(out);
+    w.raw(archiveMagic);
+    w.raw(String(archiveVersion).c_str());
+    w.raw("\n");
+
+    String lang = slurp("AsyncWiFiSettings-language");
+    if (lang.length()) w.record("AsyncWiFiSettings-language", lang);
+    if (backupSecrets) {
+        w.record("wifi-ssid", slurp("wifi-ssid"));
+        w.record("wifi-password", slurp("wifi-password"));
+    }
+
+    for (auto *list : {&primary, &extras}) {
+        for (auto &p : *list) {
+            if (!p->name.length() || (p->secret() && !backupSecrets)) continue;
+            if (!p->blob()) {
+                w.record(p->name, p->value);
+                continue;
+            }
+            w.encoded(p->name);
+            w.raw("=");
+            uint8_t buf[ASYNCWIFISETTINGS_CHUNK_SIZE];
+            size_t offset = 0, n;
+            while ((n = storage->readChunk(p->name, offset, buf, sizeof(buf)))) {
+                w.encoded(buf, n);
+                offset += n;
+            }
+            w.raw("\n");
+        }
+    }
+    w.finish();
+}
+
+// Checks the archive in storage under key; with apply, also restores it.
+// The archive is read from storage in chunks, so it can be larger than
+// the available memory. Returns false for an invalid archive, or, with
+// apply, when writing failed.
+bool AsyncWiFiSettingsClass::restoreArchive(const String &key, bool apply) {
+    auto find = [this](const String &name) -> AsyncWiFiSettingsParameter * {
+        for (auto *list : {&primary, &extras}) {
+            for (auto &p : *list) {
+                if (p->name.length() && p->name == name) return p;
+            }
+        }
+        return nullptr;
+    };
+
+    std::vector<Change> changes;
+    bool ok = true;
+    AsyncWiFiSettingsBlob *blob = nullptr;
+    bool staged = false; // blob data goes to its staging key, like an upload
+    ArchiveReader reader;
+
+    reader.onKey = [&](const String &name) {
+        auto *p = find(name);
+        blob = p ? p->blob() : nullptr;
+        staged = apply && blob && !blob->uploader;
+        if (apply && blob && !staged) ok = false; // the staging key is taken
+        if (staged) blob->upload(0, nullptr, 0, false);
+        return blob != nullptr;
+    };
+    reader.onData = [&](const uint8_t *data, size_t len) {
+        if (staged) blob->upload(1, data, len, false);
+        return true;
+    };
+    reader.onRecord = [&](const String &name, const String &value) {
+        if (!apply) return true;
+        if (blob) {
+            if (!staged) return true;
+            blob->upload(1, nullptr, 0, true);
+            if (!blob->ok) ok = false;
+            recordChange(changes, name, blob->previous, blob->value);
+        } else if (name == "wifi-ssid" || name == "wifi-password") {
+            recordChange(changes, name, slurp(name), value);
+            if (!spurt(name, value)) ok = false;
+        } else if (name == "AsyncWiFiSettings-language") {
+            if (!spurt(name, value)) ok = false;
+            if (AsyncWiFiSettingsLanguage::available(value)) {
+                recordChange(changes, name, language, value);
+                language = value;
+                selectLanguage(language);
+            }
+        } else if (auto *p = find(name)) {
+            String old = p->effective();
+            p->value = value;
+            if (!p->store()) ok = false;
+            recordChange(changes, name, old, p->effective());
+        }
+        // Anything else is unknown to this firmware, and skipped
+        return true;
+    };
+
+    uint8_t buf[ASYNCWIFISETTINGS_CHUNK_SIZE];
+    size_t offset = 0, n;
+    while ((n = storage->readChunk(key, offset, buf, sizeof(buf)))) {
+        if (!reader.feed(buf, n)) return false;
+        offset += n;
+    }
+    if (!reader.done) return false;
+    if (!apply) return true;
+
+    // After a storage error, what was written is still announced
+    snapshotPublish();
+    notify(changes);
+    if (ok && onConfigSaved) onConfigSaved();
+    events->send(ok ? texts->saved : texts->error_fs, "saved");
+    return ok;
+}
+
+// The archive is staged in storage and checked in full before anything is
+// written, so a truncated or corrupted archive changes nothing.
+bool AsyncWiFiSettingsClass::restore(Stream &in) {
+    if (restoring) return false; // the staging area is taken by /restore
+    bool ok = spurt(restoreKey, "");
+    uint8_t buf[ASYNCWIFISETTINGS_CHUNK_SIZE];
+    size_t n;
+    while ((n = in.readBytes(buf, sizeof(buf)))) {
+        if (!storage->append(restoreKey, buf, n)) ok = false;
+    }
+    ok = ok && restoreArchive(restoreKey, false) && restoreArchive(restoreKey, true);
+    spurt(restoreKey, "");
+    return ok;
+}
+
 String AsyncWiFiSettingsClass::pstring(const String &name, const String &init, const String &label) {
     begin();
     auto *x = new AsyncWiFiSettingsPassword();
+    x->owner = this;
     x->name = name;
     x->label = label.length() ? label : name;
     x->init = init;
-    x->fill();
+    load(x);
 
     params()->push_back(x);
+    snapshotAppend(x);
     return x->value.length() ? x->value : x->init;
 }
 
 String AsyncWiFiSettingsClass::string(const String &name, const String &init, const String &label) {
     begin();
     auto *x = new AsyncWiFiSettingsString();
+    x->owner = this;
     x->name = name;
     x->label = label.length() ? label : name;
     x->init = init;
-    x->fill();
+    load(x);
 
     params()->push_back(x);
+    snapshotAppend(x);
     return x->value.length() ? x->value : x->init;
 }
 
@@ -349,25 +1114,60 @@ String AsyncWiFiSettingsClass::string(const String &name, unsigned int min_lengt
 long AsyncWiFiSettingsClass::dropdown(const String &name, std::vector<String> options, long init, const String &label) {
     begin();
     auto *x = new AsyncWiFiSettingsDropdown();
+    x->owner = this;
     x->name = name;
     x->label = label.length() ? label : name;
     x->init = init;
     x->options = options;
-    x->fill();
+    load(x);
+
+    params()->push_back(x);
+    snapshotAppend(x);
+    return (x->value.length() ? x->value : x->init).toInt();
+}
+
+long AsyncWiFiSettingsClass::dropdown(const String &name, const char *const *options, size_t count, long init, const String &label) {
+    begin();
+    auto *x = new AsyncWiFiSettingsFlashDropdown();
+    x->owner = this;
+    x->name = name;
+    x->label = label.length() ? label : name;
+    x->init = String(init);
+    x->table = options;
+    x->count = count;
+    load(x);
 
     params()->push_back(x);
+    snapshotAppend(x);
+    return (x->value.length() ? x->value : x->init).toInt();
+}
+
+long AsyncWiFiSettingsClass::dropdown(const String &name, TCallbackOption options, long init, const String &label) {
+    begin();
+    auto *x = new AsyncWiFiSettingsFlashDropdown();
+    x->owner = this;
+    x->name = name;
+    x->label = label.length() ? label : name;
+    x->init = String(init);
+    x->generator = options;
+    load(x);
+
+    params()->push_back(x);
+    snapshotAppend(x);
     return (x->value.length() ? x->value : x->init).toInt();
 }
 
 long AsyncWiFiSettingsClass::integer(const String &name, long init, const String &label) {
     begin();
     auto *x = new AsyncWiFiSettingsInt();
+    x->owner = this;
     x->name = name;
     x->label = label.length() ? label : name;
     x->init = init;
-    x->fill();
+    load(x);
 
     params()->push_back(x);
+    snapshotAppend(x);
     return (x->value.length() ? x->value : x->init).toInt();
 }
 
@@ -381,12 +1181,14 @@ long AsyncWiFiSettingsClass::integer(const String &name, long min, long max, lon
 float AsyncWiFiSettingsClass::floating(const String &name, float init, const String &label) {
     begin();
     auto *x = new AsyncWiFiSettingsFloat();
+    x->owner = this;
     x->name = name;
     x->label = label.length() ? label : name;
     x->init = init;
-    x->fill();
+    load(x);
 
     params()->push_back(x);
+    snapshotAppend(x);
     return (x->value.length() ? x->value : x->init).toFloat();
 }
 
@@ -400,22 +1202,38 @@ float AsyncWiFiSettingsClass::floating(const String &name, long min, long max, f
 bool AsyncWiFiSettingsClass::checkbox(const String &name, bool init, const String &label) {
     begin();
     auto *x = new AsyncWiFiSettingsBool();
+    x->owner = this;
     x->name = name;
     x->label = label.length() ? label : name;
     x->init = String((int)init);
-    x->fill();
+    load(x);
 
     // Apply default immediately because a checkbox has no placeholder to
     // show the default, and other UI elements aren't sufficiently pretty.
     if (!x->value.length()) x->value = x->init;
 
     params()->push_back(x);
+    snapshotAppend(x);
     return x->value.toInt();
 }
 
+size_t AsyncWiFiSettingsClass::blob(const String &name, const String &label) {
+    begin();
+    auto *x = new AsyncWiFiSettingsBlob();
+    x->owner = this;
+    x->name = name;
+    x->label = label.length() ? label : name;
+    load(x);
+
+    params()->push_back(x);
+    snapshotAppend(x);
+    return storage->size(name);
+}
+
 void AsyncWiFiSettingsClass::html(const String &tag, const String &contents, bool escape) {
     begin();
     auto *x = new AsyncWiFiSettingsHTML();
+    x->owner = this;
     x->value = tag;
     x->label = contents;
     x->min = escape;
@@ -432,37 +1250,116 @@ void AsyncWiFiSettingsClass::warning(const String &contents, bool escape) {
 }
 
 void AsyncWiFiSettingsClass::heading(const String &contents, bool escape) {
+    begin(); // built-in parameters go before the first heading
+    if (!extra) headings.push_back(primary.size());
     html("h2", contents, escape);
 }
 
+uint32_t AsyncWiFiSettingsClass::generation() {
+    return snapshot->seq.load(std::memory_order_acquire) >> 1;
+}
+
+bool AsyncWiFiSettingsClass::getString(const char *name, char *buf, size_t size) {
+    for (;;) {
+        uint32_t s1 = snapshot->seq.load(std::memory_order_acquire);
+        SnapshotBuffer *b = snapshot->buffers[(s1 >> 1) & 1].load(std::memory_order_acquire);
+
+        bool found = false;
+        if (b) {
+            size_t used = b->used.load(std::memory_order_acquire);
+            if (used > b->capacity) used = b->capacity;
+            const char *p = b->data;
+            const char *end = b->data + used;
+            while (p < end && !found) {
+                auto *n_end = (const char *)memchr(p, 0, end - p);
+                if (!n_end) break;
+                auto *v_end = (const char *)memchr(n_end + 1, 0, end - n_end - 1);
+                if (!v_end) break;
+                if (strcmp(p, name) == 0) {
+                    found = true;
+                    if (size) {
+                        size_t n = v_end - n_end - 1;
+                        if (n >= size) n = size - 1;
+                        memcpy(buf, n_end + 1, n);
+                        buf[n] = '\0';
+                    }
+                }
+                p = v_end + 1;
+            }
+        }
+
+        // The buffer read above is only overwritten once a writer starts on
+        // the generation after next.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t s2 = snapshot->seq.load(std::memory_order_relaxed);
+        if (s2 - (s1 & ~1u) < 3) return found;
+    }
+}
+
+long AsyncWiFiSettingsClass::getInteger(const char *name, long fallback) {
+    char buf[24];
+    return getString(name, buf, sizeof(buf)) ? strtol(buf, nullptr, 10) : fallback;
+}
+
+float AsyncWiFiSettingsClass::getFloating(const char *name, float fallback) {
+    char buf[32];
+    return getString(name, buf, sizeof(buf)) ? strtof(buf, nullptr) : fallback;
+}
+
+bool AsyncWiFiSettingsClass::getCheckbox(const char *name, bool fallback) {
+    return getInteger(name, fallback);
+}
+
+void AsyncWiFiSettingsClass::onChange(const String &name, TCallbackChange callback) {
+    subscriptions.push_back({name, false, callback, nullptr});
+}
+
+void AsyncWiFiSettingsClass::onGroupChange(const String &prefix, TCallback callback) {
+    subscriptions.push_back({prefix, true, nullptr, callback});
+}
+
 void AsyncWiFiSettingsClass::markExtra() {
     extra = true;
 }
 
-void AsyncWiFiSettingsClass::httpSetup(bool wifi) {
-    begin();
+bool AsyncWiFiSettingsClass::redirect(AsyncWebServerRequest *request) {
+    if (!configureWifi) return false;
+    // iPhone doesn't deal well with redirects to http://hostname/ and
+    // will wait 40 to 60 seconds before succesful retry. Works flawlessly
+    // with http://ip/ though.
+    if (request->host() == ip) return false;
 
-    static int num_networks = -1;
-    static String ip = WiFi.softAPIP().toString();
-    static bool const configureWifi = wifi;
+    request->redirect("http://" + ip + base + "/");
+    return true;
+}
 
-    if (onHttpSetup) onHttpSetup(&http);
+AsyncWebServer &AsyncWiFiSettingsClass::server() {
+    return *http;
+}
 
-    auto redirect = [](AsyncWebServerRequest *request) {
-        if (!configureWifi) return false;
-        // iPhone doesn't deal well with redirects to http://hostname/ and
-        // will wait 40 to 60 seconds before succesful retry. Works flawlessly
-        // with http://ip/ though.
-        if (request->host() == ip) return false;
+// Registers a handler under base, and remembers it for the destructor
+void AsyncWiFiSettingsClass::route(const String &path, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload) {
+    handlers.push_back(&http->on((base + path).c_str(), method, onRequest, onUpload));
+}
 
-        request->redirect("http://" + ip + "/");
-        return true;
-    };
+void AsyncWiFiSettingsClass::httpSetup(bool wifi) {
+    begin();
 
-    http.on("/", HTTP_GET, [this, redirect](AsyncWebServerRequest *request) {
-        if (redirect(request)) return;
+    ip = WiFi.softAPIP().toString();
+    configureWifi = wifi;
 
+    // The handlers read the above, so they only need to be added once
+    if (httpBegun) return;
+    httpBegun = true;
+
+    if (onHttpSetup) onHttpSetup(http);
+
+    // Renders section n, or the whole portal for -1
+    auto page = [this](AsyncWebServerRequest *request, int n) {
+        AsyncWiFiSettingsStopwatch t;
+        uint32_t heap = ESP.getFreeHeap();
         AsyncResponseStream *response = request->beginResponseStream("text/html");
+        CountingPrint out(*response);
 
         bool interactive = false;
         if (request->hasHeader("User-Agent")) {
@@ -474,176 +1371,426 @@ void AsyncWiFiSettingsClass::httpSetup(bool wifi) {
 
         if (interactive && onPortalView) onPortalView();
 
-        response->print(F("<!DOCTYPE html>\n<meta charset=UTF-8><title>"));
-        response->print(html_entities(hostname));
-        response->print(F("</title><meta name=viewport content='width=device-width,initial-scale=1'>"
+        out.print(F("<!DOCTYPE html>\n<meta charset=UTF-8><title>"));
+        out.print(html_entities(hostname));
+        out.print(F("</title><meta name=viewport content='width=device-width,initial-scale=1'>"
                           "<style>.c,.i,.w{display:block}*{box-sizing:border-box}html{background:#444;font:10pt sans-serif;width:100vw;max-width:100%}body{background:#ccc;color:#000;padding:1em;margin:1em auto}a{color:#000;text-decoration:none}label{clear:both}input:not([type^=c]),select{display:block;width:100%;border:1px solid #444;padding:.3ex}input[type^=s]{display:inline;width:auto;background:#de1;padding:1ex;border:1px solid #000;border-radius:1ex}[type^=c]{float:left;margin-left:-1.5em}:not([type^=s]):focus{outline:#d1ed1e solid 2px}.w::before{content:'\\26a0\\fe0f'}p::before{margin-left:-2em;padding-top:1ex}.i::before{content:'\\2139\\fe0f'}.c{padding-left:2em}.i,.w{padding:.5ex .5ex .5ex 3em;background:#aaa;min-height:3em}</style>"
-                          "<form action=/restart method=post>"));
-        response->print(F("<input type=submit value=\""));
-        response->print(_WSL_T.button_restart);
-        response->print(F("\"></form><hr><h1>"));
-        response->print(_WSL_T.title);
-        response->print(F("</h1><form method=post><label>"));
+                          "<form action="));
+        out.print(base);
+        out.print(F("/restart method=post><input type=submit value=\""));
+        out.print(texts->button_restart);
+        out.print(F("\"></form><hr><h1>"));
+        out.print(texts->title);
+        out.print(F("</h1><form method=post id=f><label>"));
 
         // Don't waste time scanning in captive portal detection (Apple)
-        if (configureWifi && interactive) {
-            response->print(_WSL_T.ssid);
-            response->print(F(":<br><b class=s>"));
-            response->print(_WSL_T.scanning_long);
-            response->print("</b>");
-            if (num_networks < 0) num_networks = WiFi.scanNetworks();
-            Serial.print(num_networks, DEC);
+        if (configureWifi && interactive && n <= 0) {
+            out.print(texts->ssid);
+            out.print(F(":<br><b class=s>"));
+            out.print(texts->scanning_long);
+            out.print("</b>");
+            scanFinished();
+            if (num_networks < 0) num_networks = scan();
+            Serial.print((int)num_networks, DEC);
             Serial.println(F(" WiFi networks found."));
 
-            response->print(F(
+            out.print(F(
                 "<style>.s{display:none}</style>" // hide "scanning"
                 "<select name=ssid onchange=\"document.getElementsByName('password')[0].value=''\">"));
 
-            String current = slurp("/wifi-ssid");
-            bool found = false;
-            for (int i = 0; i < num_networks; i++) {
-                String opt = F("<option value='{ssid}'{sel}>{ssid} {lock} {1x}</option>");
-                String ssid = WiFi.SSID(i);
-                wifi_auth_mode_t mode = WiFi.encryptionType(i);
-
-                opt.replace("{sel}", ssid == current && !found ? " selected" : "");
-                opt.replace("{ssid}", html_entities(ssid));
-                opt.replace("{lock}", mode != WIFI_AUTH_OPEN ? "&#x1f512;" : "");
-                opt.replace("{1x}", mode == WIFI_AUTH_WPA2_ENTERPRISE ? _WSL_T.dot1x : F(""));
-                response->print(opt);
-
-                if (ssid == current) found = true;
-            }
-            if (!found && current.length()) {
-                String opt = F("<option value='{ssid}' selected>{ssid} (&#x26a0; not in range)</option>");
-                opt.replace("{ssid}", html_entities(current));
-                response->print(opt);
-            }
+            networks(out);
 
-            response->print(F("</select></label> <a href=/rescan onclick=\"this.innerHTML='"));
-            response->print(_WSL_T.scanning_short);
-            response->print("';\">");
-            response->print(_WSL_T.rescan);
-            response->print(F("</a><p><label>"));
+            out.print(F("</select></label> <a id=r href="));
+            out.print(base);
+            out.print(F("/rescan onclick=\"this.innerHTML='"));
+            out.print(texts->scanning_short);
+            out.print("';\">");
+            out.print(texts->rescan);
+            out.print(F("</a><p><label>"));
 
-            response->print(_WSL_T.wifi_password);
-            response->print(F(":<br><input name=password value='"));
-            if (slurp("/wifi-password").length()) response->print("##**##**##**");
-            response->print(F("'></label><hr>"));
+            out.print(texts->wifi_password);
+            out.print(F(":<br><input name=password value='"));
+            if (slurp("wifi-password").length()) out.print("##**##**##**");
+            out.print(F("'></label><hr>"));
         }
 
-        if (AsyncWiFiSettingsLanguage::multiple()) {
-            response->print(F("<label>"));
-            response->print(_WSL_T.language);
-            response->print(F(":<br><select name=language>"));
+        if (AsyncWiFiSettingsLanguage::multiple() && n <= 0) {
+            out.print(F("<label>"));
+            out.print(texts->language);
+            out.print(F(":<br><select name=language>"));
 
             for (auto &lang : AsyncWiFiSettingsLanguage::languages) {
-                String opt = F("<option value='{code}'{sel}>{name}</option>");
-                opt.replace("{code}", lang.first);
-                opt.replace("{name}", lang.second);
-                opt.replace("{sel}", language == lang.first ? " selected" : "");
-                response->print(opt);
+                out.print(F("<option value='"));
+                out.print(lang.code);
+                out.print(language == lang.code ? F("' selected>") : F("'>"));
+                out.print(lang.name);
+                out.print(F("</option>"));
             }
-            response->print(F("</select></label>"));
+            out.print(F("</select></label>"));
         }
 
-        for (auto &p : primary) {
-            response->print(p->html());
+        size_t first, last;
+        section(n, first, last);
+        for (size_t i = first; i < last; i++) {
+            primary[i]->render(out);
         }
 
-        response->print(F(
+        out.print(F(
             "<p style='position:sticky;bottom:0;text-align:right'>"
-            "<input type=submit value=\""));
-        response->print(_WSL_T.button_save);
-        response->print(F("\"style='font-size:150%'></form>"));
+            "<b id=v></b> <input type=submit value=\""));
+        out.print(texts->button_save);
+        out.print(F("\"style='font-size:150%'></form>"));
+
+        // Saves and rescans without reloading; changes arrive on the event
+        // stream and scan results are polled from /networks.
+        out.print(F(
+            "<script>var f=document.getElementById('f'),r=document.getElementById('r'),t=r&&r.innerHTML,p='"));
+        out.print(base);
+        out.print(F("',e=new EventSource(p+'/events');"
+            "function x(u,b){return fetch(u,{method:b?'POST':'GET',headers:{'X-Requested-With':'fetch'},body:b})}"
+            "f.onsubmit=function(v){v.preventDefault();x(location.pathname,new URLSearchParams(new FormData(f))).then(function(s){if(s.status==205)location.reload()})};"
+            "function n(){x(p+'/networks').then(function(s){if(s.status==202)setTimeout(n,500);else s.text().then(function(h){f.ssid.innerHTML=h;r.innerHTML=t})})}"
+            "if(r)r.addEventListener('click',function(v){v.preventDefault();x(r.href).then(n)});"
+            "e.addEventListener('change',function(m){var d=JSON.parse(m.data),i=f.elements[d.name];if(!i||i.type=='file'||i.type=='password')return;if(i.type=='checkbox')i.checked=d.value=='1';else i.value=d.value});"
+            "e.addEventListener('saved',function(m){document.getElementById('v').textContent=m.data})"
+            "</script>"));
+
+        for (size_t i = first; i < last; i++) {
+            out.print(primary[i]->form());
+        }
+
+        if (n <= 0) {
+            String b = F(
+                "<hr><a href={base}/backup>{backup}</a>"
+                "<form action={base}/restore method=post enctype=multipart/form-data>"
+                "<input type=file name=archive> <input type=submit value='{restore}'></form>");
+            b.replace("{base}", base);
+            b.replace("{backup}", texts->backup);
+            b.replace("{restore}", texts->restore);
+            out.print(b);
+        }
+
+        if (paged && n == 0) {
+            out.print(F("<hr><ul>"));
+            for (size_t i = 0; i < headings.size(); i++) {
+                String li = F("<li><a href={base}/section/{n}>{label}</a>");
+                auto *h = primary[headings[i]];
+                li.replace("{base}", base);
+                li.replace("{n}", String(i + 1));
+                li.replace("{label}", h->min ? html_entities(h->label) : h->label);
+                out.print(li);
+            }
+            out.print(F("</ul>"));
+        } else if (n > 0) {
+            out.print(F("<hr><a href="));
+            out.print(base);
+            out.print(F("/>&#x2190; "));
+            out.print(texts->title);
+            out.print(F("</a>"));
+        }
         request->send(response);
+        metrics.render(n > 0 ? metrics.section : metrics.portal, t.elapsed(), out.bytes, heap);
+    };
+
+    route("/", HTTP_GET, [this, page](AsyncWebServerRequest *request) {
+        if (redirect(request)) return;
+        metrics.request(AsyncWiFiSettingsMetrics::ROOT_GET);
+        page(request, paged ? 0 : -1);
+    });
+
+    route("/section", HTTP_GET, [this, page](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::SECTION_GET);
+        int n = sectionNumber(request);
+        if (n < 0) {
+            request->send(404, "text/plain", "404");
+            return;
+        }
+        page(request, n);
     });
 
-    http.on("/", HTTP_POST, [this](AsyncWebServerRequest *request) {
+    // Saves only what page() rendered for the same n
+    auto save = [this](AsyncWebServerRequest *request, int n) {
         bool ok = true;
+        bool reload = false;
+        std::vector<Change> changes;
 
-        if (configureWifi) {
+        if (configureWifi && n <= 0) {
             auto ssid = request->arg("ssid");
             if (!ssid.isEmpty()) {
-                if (!spurt("/wifi-ssid", ssid)) ok = false;
+                recordChange(changes, "wifi-ssid", slurp("wifi-ssid"), ssid);
+                if (!spurt("wifi-ssid", ssid)) ok = false;
             }
 
             String pw = request->arg("password");
             if (!pw.isEmpty() && pw != "##**##**##**") {
-                if (!spurt("/wifi-password", pw)) ok = false;
+                recordChange(changes, "wifi-password", slurp("wifi-password"), pw);
+                if (!spurt("wifi-password", pw)) ok = false;
             }
         }
 
-        if (AsyncWiFiSettingsLanguage::multiple()) {
-            if (!spurt("/AsyncWiFiSettings-language", request->arg("language"))) ok = false;
-            // Don't update immediately, because there is currently
-            // no mechanism for reloading param strings.
-            // language = request->arg("language");
-            // AsyncWiFiSettingsLanguage::select(T, language);
+        if (AsyncWiFiSettingsLanguage::multiple() && n <= 0) {
+            String lang = request->arg("language");
+            if (!spurt("AsyncWiFiSettings-language", lang)) ok = false;
+            if (AsyncWiFiSettingsLanguage::available(lang)) {
+                recordChange(changes, "AsyncWiFiSettings-language", language, lang);
+                reload = lang != language; // all labels change
+                language = lang;
+                selectLanguage(language);
+            }
         }
 
-        for (auto &p : primary) {
+        size_t first, last;
+        section(n, first, last);
+        for (size_t i = first; i < last; i++) {
+            auto &p = primary[i];
+            String old = p->effective();
             p->set(request->arg(p->name));
             if (!p->store()) ok = false;
+            if (p->name.length()) recordChange(changes, p->name, old, p->effective());
         }
+        snapshotPublish();
 
         if (ok) {
-            request->redirect("/");
+            if (fetched(request)) request->send(reload ? 205 : 204);
+            else request->redirect(n > 0 ? request->url() : base + "/");
+            notify(changes);
             if (onConfigSaved) onConfigSaved();
         } else {
-            // Could be missing SPIFFS.begin(), unformatted filesystem, or broken flash.
-            request->send(500, "text/plain", _WSL_T.error_fs);
+            // Could be missing SPIFFS.begin(), unformatted filesystem, full NVS, or broken flash.
+            request->send(500, "text/plain", texts->error_fs);
         }
+        events->send(ok ? texts->saved : texts->error_fs, "saved");
+    };
+
+    route("/", HTTP_POST, [this, save](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::ROOT_POST);
+        save(request, paged ? 0 : -1);
     });
 
-    http.on("/extras", HTTP_GET, [this](AsyncWebServerRequest *request) {
+    route("/section", HTTP_POST, [this, save](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::SECTION_POST);
+        int n = sectionNumber(request);
+        if (n < 0) {
+            request->send(404, "text/plain", "404");
+            return;
+        }
+        save(request, n);
+    });
+
+    route("/extras", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::EXTRAS_GET);
+        AsyncWiFiSettingsStopwatch t;
+        uint32_t heap = ESP.getFreeHeap();
         AsyncResponseStream *response = request->beginResponseStream("application/json");
-        response->print("{");
+        CountingPrint out(*response);
+        out.print("{");
         bool needsComma = false;
         for (auto &p : extras) {
             auto s = p->json();
             if (s == "") continue;
-            if (needsComma) response->print(",");
-            response->print(s);
+            if (needsComma) out.print(",");
+            out.print(s);
             needsComma = true;
         }
-        response->print("}");
+        out.print("}");
         request->send(response);
+        metrics.render(metrics.extras, t.elapsed(), out.bytes, heap);
     });
 
-    http.on("/extras", HTTP_POST, [this](AsyncWebServerRequest *request) {
+    route("/extras", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::EXTRAS_POST);
         bool ok = true;
+        std::vector<Change> changes;
 
         for (auto &p : extras) {
+            String old = p->effective();
             p->set(request->arg(p->name));
             if (!p->store()) ok = false;
+            if (p->name.length()) recordChange(changes, p->name, old, p->effective());
         }
+        snapshotPublish();
 
         if (ok) {
-            request->redirect("/");
+            if (fetched(request)) request->send(204);
+            else request->redirect(base + "/");
+            notify(changes);
             if (onConfigSaved) onConfigSaved();
         } else {
-            // Could be missing SPIFFS.begin(), unformatted filesystem, or broken flash.
-            request->send(500, "text/plain", _WSL_T.error_fs);
+            // Could be missing SPIFFS.begin(), unformatted filesystem, full NVS, or broken flash.
+            request->send(500, "text/plain", texts->error_fs);
         }
+        events->send(ok ? texts->saved : texts->error_fs, "saved");
     });
 
-    http.on("/restart", HTTP_POST, [this](AsyncWebServerRequest *request) {
-        request->send(200, "text/plain", _WSL_T.bye);
+    auto findBlob = [this](const String &name) -> AsyncWiFiSettingsBlob * {
+        for (auto *list : {&primary, &extras}) {
+            for (auto &p : *list) {
+                auto *b = p->blob();
+                if (b && b->name == name) return b;
+            }
+        }
+        return nullptr;
+    };
+
+    // Streamed to storage one multipart chunk at a time, and only replaces
+    // the stored value once complete
+    route("/blob", HTTP_POST, [this, findBlob](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::BLOB);
+        auto *b = findBlob(request->arg("name"));
+        if (!b) {
+            request->send(404, "text/plain", "404");
+            return;
+        }
+        if (b->uploader != request) {
+            // No file, or another upload to the same blob is in progress
+            request->send(b->uploader ? 409 : 400, "text/plain", b->uploader ? "409" : "400");
+            return;
+        }
+        b->uploader = nullptr;
+        if (b->ok) {
+            request->redirect(base + "/");
+            std::vector<Change> changes;
+            recordChange(changes, b->name, b->previous, b->value);
+            notify(changes);
+            if (onConfigSaved) onConfigSaved();
+        } else {
+            request->send(500, "text/plain", texts->error_fs);
+        }
+    }, [this, findBlob](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final) {
+        (void)filename;
+        auto *b = findBlob(request->arg("name"));
+        if (!b) return;
+        if (!index && !b->uploader) {
+            b->uploader = request;
+            request->onDisconnect([this, b, request] {
+                if (b->uploader != request) return;
+                b->uploader = nullptr;
+                spurt(b->staging(), "");
+            });
+        }
+        if (b->uploader != request) return;
+        b->upload(index, data, len, final);
+        if (final) snapshotPublish();
+    });
+
+    route("/restart", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::RESTART);
+        request->send(200, "text/plain", texts->bye);
         if (onRestart) onRestart();
         ESP.restart();
     });
 
-    http.on("/rescan", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        request->redirect("/");
-        num_networks = WiFi.scanNetworks();
+    route("/rescan", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::RESCAN);
+        if (fetched(request)) {
+            // The portal polls /networks for the results
+            request->send(204);
+            if (scanning) return;
+            scanStarted = AsyncWiFiSettingsStopwatch();
+            num_networks = 0; // the old results are deleted
+            scanning = true;
+            if (WiFi.scanNetworks(true) == WIFI_SCAN_FAILED) scanning = false;
+            return;
+        }
+        request->redirect(base + "/");
+        if (!scanning) num_networks = scan();
     });
 
-    http.onNotFound([this, &redirect](AsyncWebServerRequest *request) {
-        if (redirect(request)) return;
-        request->send(404, "text/plain", "404");
+    // Polled by the portal after a background rescan
+    route("/networks", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::NETWORKS);
+        if (scanning) {
+            request->send(202);
+            return;
+        }
+        scanFinished();
+        AsyncResponseStream *response = request->beginResponseStream("text/html");
+        networks(*response);
+        request->send(response);
+    });
+
+    route("/backup", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::BACKUP);
+        AsyncResponseStream *response = request->beginResponseStream("text/plain");
+        response->addHeader("Content-Disposition", "attachment; filename=\"" + hostname + ".txt\"");
+        backup(*response);
+        request->send(response);
     });
-    http.begin();
+
+    // Staged in storage one multipart chunk at a time, then checked in full
+    route("/restore", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::RESTORE);
+        if (restoring != request) {
+            // No file, or another restore is in progress
+            request->send(restoring ? 409 : 400, "text/plain", restoring ? "409" : "400");
+            return;
+        }
+        if (!restoreStaged) {
+            request->send(500, "text/plain", texts->error_fs);
+        } else if (!restoreArchive(restoreKey, false)) {
+            request->send(400, "text/plain", texts->error_backup);
+        } else if (!restoreArchive(restoreKey, true)) {
+            request->send(500, "text/plain", texts->error_fs);
+        } else if (fetched(request)) {
+            request->send(204);
+        } else {
+            request->redirect(base + "/");
+        }
+        spurt(restoreKey, "");
+        restoring = nullptr;
+    }, [this](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final) {
+        (void)filename; (void)final;
+        if (!index && !restoring) {
+            restoring = request;
+            restoreStaged = spurt(restoreKey, "");
+            request->onDisconnect([this, request] {
+                if (restoring != request) return;
+                restoring = nullptr;
+                spurt(restoreKey, "");
+            });
+        }
+        if (restoring != request) return;
+        if (restoreStaged && len) restoreStaged = storage->append(restoreKey, data, len);
+    });
+
+    // Runs on the WiFi event task, so it only stores the outcome. The results,
+    // metrics and event source are only touched from the web server's task.
+    scanDone = WiFi.onEvent([this](arduino_event_id_t, arduino_event_info_t) {
+        int n = WiFi.scanComplete();
+        if (n == WIFI_SCAN_RUNNING || !scanning) return;
+        scanTook = scanStarted.elapsed();
+        num_networks = n;
+        scanned = true;
+        scanning = false;
+    }, ARDUINO_EVENT_WIFI_SCAN_DONE);
+    http->addHandler(events);
+
+#if ASYNCWIFISETTINGS_TRACE
+    route("/boot-trace", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        AsyncResponseStream *response = request->beginResponseStream("text/plain");
+        trace.print(*response);
+        request->send(response);
+    });
+#endif
+
+#if ASYNCWIFISETTINGS_METRICS
+    route("/metrics", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        metrics.request(AsyncWiFiSettingsMetrics::METRICS);
+        AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+        metrics.print(*response);
+        request->send(response);
+    });
+#endif
+
+    // A server has only one of these, which goes to the instance at its root
+    if (!base.length()) {
+        http->onNotFound([this](AsyncWebServerRequest *request) {
+            if (redirect(request)) return;
+            metrics.request(AsyncWiFiSettingsMetrics::NOT_FOUND);
+            request->send(404, "text/plain", "404");
+        });
+    }
+    http->begin();
 }
 
 void AsyncWiFiSettingsClass::portal() {
@@ -692,18 +1839,26 @@ void AsyncWiFiSettingsClass::portal() {
 
 bool AsyncWiFiSettingsClass::connect(bool portal, int wait_seconds) {
     begin();
+    AsyncWiFiSettingsTraceScope t(trace, "connect");
 
     if (WiFi.getMode() != WIFI_OFF) {
         WiFi.mode(WIFI_OFF);
     }
 
-    esp_wifi_set_bandwidth(WIFI_IF_AP, WIFI_BW_HT20);
+    {
+        AsyncWiFiSettingsTraceScope t(trace, "bandwidth");
+        esp_wifi_set_bandwidth(WIFI_IF_AP, WIFI_BW_HT20);
+    }
 
     WiFi.persistent(false);
     WiFi.setAutoReconnect(false);
 
-    String ssid = slurp("/wifi-ssid");
-    String pw = slurp("/wifi-password");
+    String ssid, pw;
+    {
+        AsyncWiFiSettingsTraceScope t(trace, "credentials");
+        ssid = slurp("wifi-ssid");
+        pw = slurp("wifi-password");
+    }
     if (ssid.length() == 0) {
         Serial.println(F("First contact!\n"));
         this->portal();
@@ -715,6 +1870,18 @@ bool AsyncWiFiSettingsClass::connect(bool portal, int wait_seconds) {
     if (onConnect) onConnect();
 
     WiFi.setHostname(hostname.c_str());
+
+#if ASYNCWIFISETTINGS_TRACE
+    // Association and DHCP are only told apart by events. The handler is
+    // removed before this function returns.
+    volatile uint32_t associated = 0;
+    auto event = WiFi.onEvent([&associated](arduino_event_id_t, arduino_event_info_t) {
+        associated = micros();
+    }, ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    uint32_t began = micros();
+#endif
+
+    metrics.attempt();
     auto status = WiFi.begin(ssid.c_str(), pw.c_str());
 
     unsigned long const wait_ms = wait_seconds * 1000UL;
@@ -726,6 +1893,7 @@ bool AsyncWiFiSettingsClass::connect(bool portal, int wait_seconds) {
             lastbegin = millis();
             Serial.print("*");
             WiFi.disconnect(true, true);
+            metrics.attempt();
             status = WiFi.begin(ssid.c_str(), pw.c_str());
         } else {
             Serial.print(".");
@@ -736,6 +1904,18 @@ bool AsyncWiFiSettingsClass::connect(bool portal, int wait_seconds) {
             break;
     }
 
+    metrics.connect(status == WL_CONNECTED, millis() - starttime);
+
+#if ASYNCWIFISETTINGS_TRACE
+    WiFi.removeEvent(event);
+    uint32_t now = micros();
+    if (associated) {
+        trace.record("associate", "", began, associated - began);
+        if (status == WL_CONNECTED) trace.record("dhcp", "", associated, now - associated);
+    } else {
+        trace.record("associate", "failed", began, now - began);
+    }
+#endif
     if (status != WL_CONNECTED) {
         Serial.printf(" failed (status=%d).\n", status);
         if (onFailure) onFailure();
@@ -751,16 +1931,20 @@ bool AsyncWiFiSettingsClass::connect(bool portal, int wait_seconds) {
 void AsyncWiFiSettingsClass::begin() {
     if (begun) return;
     begun = true;
+    AsyncWiFiSettingsTraceScope t(trace, "begin");
 
     // These things can't go in the constructor because the constructor runs
-    // before ESPFS.begin()
-
-    String user_language = slurp("/AsyncWiFiSettings-language");
-    user_language.trim();
-    if (user_language.length() && AsyncWiFiSettingsLanguage::available(user_language)) {
-        language = user_language;
+    // before the filesystem is mounted
+
+    {
+        AsyncWiFiSettingsTraceScope t(trace, "language");
+        String user_language = slurp("AsyncWiFiSettings-language");
+        user_language.trim();
+        if (user_language.length() && AsyncWiFiSettingsLanguage::available(user_language)) {
+            language = user_language;
+        }
+        selectLanguage(language); // can update language
     }
-    AsyncWiFiSettingsLanguage::select(_WSL_T, language); // can update language
 
 #ifdef PORTAL_PASSWORD
 
@@ -768,8 +1952,9 @@ void AsyncWiFiSettingsClass::begin() {
         secure = checkbox(
             F("AsyncWiFiSettings-secure"),
             false,
-            _WSL_T.portal_wpa
+            texts->portal_wpa
         );
+        params()->back()->text = &AsyncWiFiSettingsLanguage::Texts::portal_wpa;
     }
 
     if (!password.length()) {
@@ -777,14 +1962,17 @@ void AsyncWiFiSettingsClass::begin() {
             F("AsyncWiFiSettings-password"),
             8, 63,
             "",
-            _WSL_T.portal_password
+            texts->portal_password
         );
+        params()->back()->text = &AsyncWiFiSettingsLanguage::Texts::portal_password;
         if (password == "") {
             // With regular 'init' semantics, the password would be changed
             // all the time.
+            AsyncWiFiSettingsTraceScope t(trace, "pwgen");
             password = pwgen();
-            params.back()->set(password);
-            params.back()->store();
+            params()->back()->set(password);
+            params()->back()->store();
+            snapshotPublish();
         }
     }
 
@@ -793,7 +1981,12 @@ void AsyncWiFiSettingsClass::begin() {
     if (hostname.endsWith("-")) hostname += ESPMAC;
 }
 
-AsyncWiFiSettingsClass::AsyncWiFiSettingsClass() : http(80) {
+AsyncWiFiSettingsClass::AsyncWiFiSettingsClass() : AsyncWiFiSettingsClass(*new AsyncWebServer(80), "") {
+    ownHttp = true;
+}
+
+AsyncWiFiSettingsClass::AsyncWiFiSettingsClass(AsyncWebServer &server, const String &base)
+    : http(&server), ownHttp(false), base(base), events(new AsyncEventSource(base + "/events")), snapshot(new Snapshot()) {
 #ifdef ESP32
     hostname = F("esp32-");
 #else
@@ -801,6 +1994,29 @@ AsyncWiFiSettingsClass::AsyncWiFiSettingsClass() : http(80) {
 #endif
 
     language = "en";
+    texts = &AsyncWiFiSettingsLanguage::languages[0].texts;
+
+    // Other instances get an NVS namespace of their own, named after their
+    // path, so their keys can't collide with those of the default instance.
+    if (base.length()) storage = ownStorage = new AsyncWiFiSettingsNVSStorage(base);
+    else storage = &spiffs;
+}
+
+AsyncWiFiSettingsClass::~AsyncWiFiSettingsClass() {
+    // The server deletes handlers when they're removed
+    if (httpBegun) {
+        WiFi.removeEvent(scanDone);
+        for (auto *h : handlers) http->removeHandler(h);
+        http->removeHandler(events);
+        if (!base.length()) http->onNotFound(nullptr);
+    } else {
+        delete events;
+    }
+    for (auto &p : primary) delete p;
+    for (auto &p : extras) delete p;
+    delete snapshot;
+    delete ownStorage;
+    if (ownHttp) delete http;
 }
 
 AsyncWiFiSettingsClass AsyncWiFiSettings;
@@ -2,41 +2,81 @@
 #define AsyncWiFiSettings_h
 
 #include <Arduino.h>
+#include <atomic>
 #include <functional>
+#include <vector>
 
 #include <ESPAsyncWebServer.h>
+#include <WiFi.h>
+
+#include "AsyncWiFiSettings_metrics.h"
+#include "AsyncWiFiSettings_storage.h"
+#include "AsyncWiFiSettings_trace.h"
+
+struct AsyncWiFiSettingsParameter;
+namespace AsyncWiFiSettingsLanguage { struct Texts; }
 
 class AsyncWiFiSettingsClass {
     public:
         typedef std::function<void(void)> TCallback;
         typedef std::function<int(void)> TCallbackReturnsInt;
         typedef std::function<void(String&)> TCallbackString;
+        typedef std::function<void(const String&, const String&, const String&)> TCallbackChange;
+        typedef std::function<const char*(size_t)> TCallbackOption;
 
         AsyncWiFiSettingsClass();
+        AsyncWiFiSettingsClass(AsyncWebServer& server, const String& base);
+        ~AsyncWiFiSettingsClass();
+        AsyncWiFiSettingsClass(const AsyncWiFiSettingsClass&) = delete;
+        AsyncWiFiSettingsClass& operator=(const AsyncWiFiSettingsClass&) = delete;
         void markExtra();
         void begin();
         bool connect(bool portal = true, int wait_seconds = 60);
         void portal();
         void httpSetup(bool softAP = false);
+        AsyncWebServer& server();
         String string(const String &name, const String &init = "", const String &label = "");
         String string(const String& name, unsigned int max_length, const String& init = "", const String& label = "");
         String string(const String& name, unsigned int min_length, unsigned int max_length, const String& init = "", const String& label = "");
         String pstring(const String& name, const String& init = "", const String& label = "");
         long dropdown(const String& name, std::vector<String> options, long init = 0, const String& label = "");
+        long dropdown(const String& name, const char* const* options, size_t count, long init = 0, const String& label = "");
+        long dropdown(const String& name, TCallbackOption options, long init = 0, const String& label = "");
         long integer(const String& name, long init = 0, const String& label = "");
         long integer(const String& name, long min, long max, long init = 0, const String& label = "");
         float floating(const String &name, float init = 0, const String &label = "");
         float floating(const String &name, long min, long max, float init = 0, const String &label = "");
         bool checkbox(const String& name, bool init = false, const String& label = "");
+        size_t blob(const String& name, const String& label = "");
         void html(const String& tag, const String& contents, bool escape = true);
         void heading(const String& contents, bool escape = true);
         void warning(const String& contents, bool escape = true);
         void info(const String& contents, bool escape = true);
 
+        uint32_t generation();
+        bool getString(const char* name, char* buf, size_t size);
+        long getInteger(const char* name, long fallback = 0);
+        float getFloating(const char* name, float fallback = 0);
+        bool getCheckbox(const char* name, bool fallback = false);
+
+        void onChange(const String& name, TCallbackChange callback);
+        void onGroupChange(const String& prefix, TCallback callback);
+
+        void backup(Print& out);
+        bool restore(Stream& in);
+
         String hostname;
         String password;
-        bool secure;
+        bool secure = false;
         String language;
+        bool paged = false;
+        bool backupSecrets = false;
+        // SPIFFS by default. Instances with a path default to an NVS namespace
+        // of that name instead, and don't follow changes to the storage of
+        // other instances.
+        AsyncWiFiSettingsStorage* storage;
+        AsyncWiFiSettingsMetrics metrics;
+        AsyncWiFiSettingsTrace trace;
 
         std::function<void(AsyncWebServer*)> onHttpSetup;
         TCallback onConnect;
@@ -50,9 +90,57 @@ class AsyncWiFiSettingsClass {
         TCallback onRestart;
         TCallbackReturnsInt onPortalWaitLoop;
     private:
-        AsyncWebServer http;
+        friend struct AsyncWiFiSettingsParameter;
+        struct Change;
+        struct Subscription;
+        struct Snapshot;
+
+        AsyncWebServer* http;
+        bool ownHttp;
+        AsyncWiFiSettingsStorage* ownStorage = nullptr;
+        String base; // prefix of every URL of the portal
+        AsyncEventSource* events;
+        std::vector<AsyncWebHandler*> handlers;
+        wifi_event_id_t scanDone = 0;
         bool begun = false;
         bool httpBegun = false;
+
+        const AsyncWiFiSettingsLanguage::Texts* texts;
+        std::vector<AsyncWiFiSettingsParameter*> primary;
+        std::vector<AsyncWiFiSettingsParameter*> extras;
+        bool extra = false;
+        std::vector<size_t> headings;
+        Snapshot* snapshot;
+        std::vector<Subscription> subscriptions;
+
+        std::atomic<int> num_networks{-1}; // also written by the WiFi event task
+        String ip;
+        bool configureWifi = false;
+        std::atomic<bool> scanning{false};
+        std::atomic<bool> scanned{false}; // duration not yet recorded
+        uint32_t scanTook = 0;
+        bool restoreStaged = true; // false once staging the upload failed
+        AsyncWebServerRequest* restoring = nullptr; // owns the staged upload
+        AsyncWiFiSettingsStopwatch scanStarted;
+
+        std::vector<AsyncWiFiSettingsParameter*>* params();
+        String slurp(const String& key);
+        bool spurt(const String& key, const String& content);
+        int scan();
+        void scanFinished();
+        void networks(Print& out);
+        void load(AsyncWiFiSettingsParameter* p);
+        void selectLanguage(String& language);
+        void section(int n, size_t& first, size_t& last);
+        int sectionNumber(AsyncWebServerRequest* request);
+        bool redirect(AsyncWebServerRequest* request);
+        void route(const String& path, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest, ArUploadHandlerFunction onUpload = nullptr);
+        void snapshotPublishLocked();
+        void snapshotPublish();
+        void snapshotAppend(AsyncWiFiSettingsParameter* p);
+        static void recordChange(std::vector<Change>& changes, const String& name, const String& old, const String& value);
+        void notify(const std::vector<Change>& changes);
+        bool restoreArchive(const String& key, bool apply);
 };
 
 extern AsyncWiFiSettingsClass AsyncWiFiSettings;
@@ -0,0 +1,54 @@
+#include "AsyncWiFiSettings_metrics.h"
+
+namespace {
+    const char *const paths[] = {"/", "/", "/extras", "/extras", "/blob", "/rescan", "/restart", "/metrics", "/section", "/section", "/backup", "/restore", "/networks", ""};
+    const char *const methods[] = {"GET", "POST", "GET", "POST", "POST", "GET", "POST", "GET", "GET", "POST", "GET", "POST", "GET", ""};
+
+    void print(Print &out, const char *name, const char *labels, uint64_t value) {
+        out.printf("wifisettings_%s%s %llu\n", name, labels, (unsigned long long)value);
+    }
+
+    void print(Print &out, const char *name, const char *labels, const AsyncWiFiSettingsHistogram &h) {
+        uint32_t cumulative = 0;
+        for (int i = 0; i < AsyncWiFiSettingsHistogram::buckets; i++) {
+            cumulative += h.counts[i];
+            out.printf("wifisettings_%s_bucket{%s%sle=\"", name, labels, *labels ? "," : "");
+            if (i < AsyncWiFiSettingsHistogram::buckets - 1) out.print(1UL << (2 * i));
+            else out.print("+Inf");
+            out.printf("\"} %u\n", (unsigned int)cumulative);
+        }
+        String braces = *labels ? "{" + String(labels) + "}" : String();
+        print(out, (String(name) + "_sum").c_str(), braces.c_str(), h.sum);
+        print(out, (String(name) + "_count").c_str(), braces.c_str(), h.count);
+        print(out, (String(name) + "_max").c_str(), braces.c_str(), h.max);
+    }
+
+    void print(Print &out, const char *path, const AsyncWiFiSettingsMetrics::Render &r) {
+        String labels = "path=\"" + String(path) + "\"";
+        String braces = "{" + labels + "}";
+        print(out, "render_us", labels.c_str(), r.us);
+        print(out, "render_bytes", braces.c_str(), r.bytes);
+        print(out, "render_heap_free_before_bytes", braces.c_str(), r.heap_before);
+        print(out, "render_heap_free_after_bytes", braces.c_str(), r.heap_after);
+        print(out, "render_heap_min_free_bytes", braces.c_str(), r.heap_min);
+    }
+} // namespace
+
+void AsyncWiFiSettingsMetrics::print(Print &out) {
+    ::print(out, "/", portal);
+    ::print(out, "/extras", extras);
+    ::print(out, "/section", section);
+    ::print(out, "scan_us", "", scan_us);
+    ::print(out, "scan_networks", "", networks);
+    ::print(out, "storage_read_us", "", read_us);
+    ::print(out, "storage_read_bytes", "", read_bytes);
+    ::print(out, "storage_write_us", "", write_us);
+    ::print(out, "storage_write_bytes", "", write_bytes);
+    ::print(out, "connect_attempts", "", connect_attempts);
+    ::print(out, "connect_failures", "", connect_failures);
+    ::print(out, "connect_ms", "", connect_ms);
+    for (int i = 0; i < NOT_FOUND; i++) {
+        out.printf("wifisettings_requests{method=\"%s\",path=\"%s\"} %u\n", methods[i], paths[i], (unsigned int)requests[i]);
+    }
+    out.printf("wifisettings_requests{path=\"other\"} %u\n", (unsigned int)requests[NOT_FOUND]);
+}
@@ -0,0 +1,137 @@
+#ifndef AsyncWiFiSettings_metrics_h
+#define AsyncWiFiSettings_metrics_h
+
+#include <Arduino.h>
+
+// Build with -DASYNCWIFISETTINGS_METRICS=1 to record metrics and serve them
+// on /metrics. Otherwise, all recording compiles to nothing.
+#ifndef ASYNCWIFISETTINGS_METRICS
+#define ASYNCWIFISETTINGS_METRICS 0
+#endif
+
+// Bucket i counts values up to 4^i; the last bucket counts everything else.
+struct AsyncWiFiSettingsHistogram {
+    static const int buckets = 14;
+    uint32_t counts[buckets] = {};
+    uint32_t count = 0;
+    uint64_t sum = 0;
+    uint32_t max = 0;
+
+    void record(uint32_t value) {
+#if ASYNCWIFISETTINGS_METRICS
+        int i = 0;
+        while (i < buckets - 1 && value > (1UL << (2 * i))) i++;
+        counts[i]++;
+        count++;
+        sum += value;
+        if (value > max) max = value;
+#else
+        (void)value;
+#endif
+    }
+};
+
+// Microseconds since construction; always 0 without metrics.
+class AsyncWiFiSettingsStopwatch {
+    public:
+#if ASYNCWIFISETTINGS_METRICS
+        uint32_t elapsed() { return micros() - start; }
+    private:
+        uint32_t start = micros();
+#else
+        uint32_t elapsed() { return 0; }
+#endif
+};
+
+struct AsyncWiFiSettingsMetrics {
+    enum Path { ROOT_GET, ROOT_POST, EXTRAS_GET, EXTRAS_POST, BLOB, RESCAN, RESTART, METRICS, SECTION_GET, SECTION_POST, BACKUP, RESTORE, NETWORKS, NOT_FOUND, PATHS };
+
+    struct Render {
+        AsyncWiFiSettingsHistogram us;
+        uint64_t bytes = 0;
+        uint32_t heap_before = 0;
+        uint32_t heap_after = 0;
+        uint32_t heap_min = 0;
+    };
+
+    Render portal;
+    Render extras;
+    Render section;
+    AsyncWiFiSettingsHistogram scan_us;
+    uint32_t networks = 0;
+    AsyncWiFiSettingsHistogram read_us;
+    uint64_t read_bytes = 0;
+    AsyncWiFiSettingsHistogram write_us;
+    uint64_t write_bytes = 0;
+    uint32_t connect_attempts = 0;
+    uint32_t connect_failures = 0;
+    AsyncWiFiSettingsHistogram connect_ms;
+    uint32_t requests[PATHS] = {};
+
+    void request(Path path) {
+#if ASYNCWIFISETTINGS_METRICS
+        requests[path]++;
+#else
+        (void)path;
+#endif
+    }
+
+    void render(Render& r, uint32_t us, size_t bytes, uint32_t heap_before) {
+#if ASYNCWIFISETTINGS_METRICS
+        r.us.record(us);
+        r.bytes += bytes;
+        r.heap_before = heap_before;
+        r.heap_after = ESP.getFreeHeap();
+        r.heap_min = ESP.getMinFreeHeap();
+#else
+        (void)r; (void)us; (void)bytes; (void)heap_before;
+#endif
+    }
+
+    void read(uint32_t us, size_t bytes) {
+#if ASYNCWIFISETTINGS_METRICS
+        read_us.record(us);
+        read_bytes += bytes;
+#else
+        (void)us; (void)bytes;
+#endif
+    }
+
+    void write(uint32_t us, size_t bytes) {
+#if ASYNCWIFISETTINGS_METRICS
+        write_us.record(us);
+        write_bytes += bytes;
+#else
+        (void)us; (void)bytes;
+#endif
+    }
+
+    void scan(uint32_t us, int n) {
+#if ASYNCWIFISETTINGS_METRICS
+        scan_us.record(us);
+        networks = n < 0 ? 0 : n;
+#else
+        (void)us; (void)n;
+#endif
+    }
+
+    void connect(bool success, uint32_t ms) {
+#if ASYNCWIFISETTINGS_METRICS
+        if (success) connect_ms.record(ms);
+        else connect_failures++;
+#else
+        (void)success; (void)ms;
+#endif
+    }
+
+    void attempt() {
+#if ASYNCWIFISETTINGS_METRICS
+        connect_attempts++;
+#endif
+    }
+
+    // Prometheus text format
+    void print(Print& out);
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "AsyncWiFiSettings_storage.h"
+
+namespace {
+    String path(const String &key) {
+        String p = "/";
+        p += key;
+        return p;
+    }
+
+    // NVS keys can hold at most 15 characters. Longer keys keep a readable
+    // beginning and get a hash of the full key appended.
+    String nvsKey(const String &key) {
+        if (key.length() <= 15) return key;
+        uint32_t h = 2166136261u; // FNV-1a
+        for (unsigned int i = 0; i < key.length(); i++) {
+            h ^= (uint8_t)key.charAt(i);
+            h *= 16777619u;
+        }
+        char hex[9];
+        snprintf(hex, sizeof(hex), "%08x", (unsigned int)h);
+        return key.substring(0, 6) + "~" + hex;
+    }
+
+    String chunkKey(const String &key, size_t n) {
+        return nvsKey(key + "#" + String((unsigned int)n));
+    }
+} // namespace
+
+size_t AsyncWiFiSettingsStorage::size(const String &key) {
+    return read(key).length();
+}
+
+size_t AsyncWiFiSettingsStorage::readChunk(const String &key, size_t offset, uint8_t *buf, size_t len) {
+    String v = read(key);
+    if (offset >= v.length()) return 0;
+    if (len > v.length() - offset) len = v.length() - offset;
+    memcpy(buf, v.c_str() + offset, len);
+    return len;
+}
+
+bool AsyncWiFiSettingsStorage::append(const String &key, const uint8_t *buf, size_t len) {
+    String v = read(key);
+    v.concat((const char *)buf, len);
+    return write(key, v);
+}
+
+bool AsyncWiFiSettingsStorage::rename(const String &from, const String &to) {
+    return write(to, read(from)) && write(from, "");
+}
+
+String AsyncWiFiSettingsFSStorage::read(const String &key) {
+    File f = fs.open(path(key), "r");
+    String r = f.readString();
+    f.close();
+    return r;
+}
+
+bool AsyncWiFiSettingsFSStorage::write(const String &key, const String &value) {
+    String fn = path(key);
+    if (value.isEmpty())
+        return fs.exists(fn) ? fs.remove(fn) : true;
+    File f = fs.open(fn, "w");
+    if (!f) return false;
+    auto w = f.print(value);
+    f.close();
+    return w == value.length();
+}
+
+bool AsyncWiFiSettingsFSStorage::exists(const String &key) {
+    return fs.exists(path(key));
+}
+
+size_t AsyncWiFiSettingsFSStorage::size(const String &key) {
+    String fn = path(key);
+    if (!fs.exists(fn)) return 0;
+    File f = fs.open(fn, "r");
+    size_t r = f.size();
+    f.close();
+    return r;
+}
+
+size_t AsyncWiFiSettingsFSStorage::readChunk(const String &key, size_t offset, uint8_t *buf, size_t len) {
+    String fn = path(key);
+    if (!fs.exists(fn)) return 0;
+    File f = fs.open(fn, "r");
+    if (!f) return 0;
+    size_t r = f.seek(offset) ? f.read(buf, len) : 0;
+    f.close();
+    return r;
+}
+
+bool AsyncWiFiSettingsFSStorage::append(const String &key, const uint8_t *buf, size_t len) {
+    File f = fs.open(path(key), "a");
+    if (!f) return false;
+    auto w = f.write(buf, len);
+    f.close();
+    return w == len;
+}
+
+AsyncWiFiSettingsNVSStorage::AsyncWiFiSettingsNVSStorage(const String &ns) : ns(nvsKey(ns)) {}
+
+bool AsyncWiFiSettingsFSStorage::rename(const String &from, const String &to) {
+    String f = path(from), t = path(to);
+    if (!fs.exists(f)) return write(to, "");
+    if (fs.rename(f, t)) return true;
+    // SPIFFS doesn't rename over an existing file
+    return fs.exists(t) && fs.remove(t) && fs.rename(f, t);
+}
+
+Preferences &AsyncWiFiSettingsNVSStorage::open() {
+    if (!begun) begun = prefs.begin(ns.c_str(), false);
+    return prefs;
+}
+
+String AsyncWiFiSettingsNVSStorage::read(const String &key) {
+    String k = nvsKey(key);
+    if (!open().isKey(k.c_str())) return "";
+    return prefs.getString(k.c_str());
+}
+
+bool AsyncWiFiSettingsNVSStorage::write(const String &key, const String &value) {
+    String k = nvsKey(key);
+    // Could have been a blob
+    for (size_t n = 0; chunkLength(key, n); n++) {
+        if (!prefs.remove(chunkKey(key, n).c_str())) return false;
+    }
+    if (value.isEmpty()) return open().isKey(k.c_str()) ? prefs.remove(k.c_str()) : true;
+    return open().putString(k.c_str(), value) == value.length();
+}
+
+bool AsyncWiFiSettingsNVSStorage::exists(const String &key) {
+    return open().isKey(nvsKey(key).c_str()) || chunkLength(key, 0);
+}
+
+size_t AsyncWiFiSettingsNVSStorage::chunkLength(const String &key, size_t n) {
+    String k = chunkKey(key, n);
+    return open().isKey(k.c_str()) ? prefs.getBytesLength(k.c_str()) : 0;
+}
+
+// Values stored with write() are a single string entry instead of chunks
+size_t AsyncWiFiSettingsNVSStorage::size(const String &key) {
+    if (!chunkLength(key, 0)) return AsyncWiFiSettingsStorage::size(key);
+    size_t total = 0;
+    for (size_t n = 0;; n++) {
+        size_t l = chunkLength(key, n);
+        if (!l) break;
+        total += l;
+    }
+    return total;
+}
+
+size_t AsyncWiFiSettingsNVSStorage::readChunk(const String &key, size_t offset, uint8_t *buf, size_t len) {
+    if (!chunkLength(key, 0)) return AsyncWiFiSettingsStorage::readChunk(key, offset, buf, len);
+    uint8_t chunk[ASYNCWIFISETTINGS_CHUNK_SIZE];
+    size_t done = 0;
+    size_t n = offset / sizeof(chunk);
+    size_t skip = offset % sizeof(chunk);
+    while (done < len) {
+        size_t l = chunkLength(key, n);
+        if (l <= skip) break;
+        prefs.getBytes(chunkKey(key, n).c_str(), chunk, sizeof(chunk));
+        size_t take = l - skip < len - done ? l - skip : len - done;
+        memcpy(buf + done, chunk + skip, take);
+        done += take;
+        skip = 0;
+        n++;
+    }
+    return done;
+}
+
+bool AsyncWiFiSettingsNVSStorage::append(const String &key, const uint8_t *buf, size_t len) {
+    String k = nvsKey(key);
+    if (!chunkLength(key, 0) && prefs.isKey(k.c_str())) {
+        // Convert to chunks first
+        String v = read(key);
+        if (!prefs.remove(k.c_str())) return false;
+        if (!append(key, (const uint8_t *)v.c_str(), v.length())) return false;
+    }
+
+    uint8_t chunk[ASYNCWIFISETTINGS_CHUNK_SIZE];
+    size_t n = 0;
+    size_t l;
+    while ((l = chunkLength(key, n)) == sizeof(chunk)) n++;
+    if (l) prefs.getBytes(chunkKey(key, n).c_str(), chunk, sizeof(chunk));
+
+    while (len) {
+        size_t take = sizeof(chunk) - l < len ? sizeof(chunk) - l : len;
+        memcpy(chunk + l, buf, take);
+        l += take;
+        buf += take;
+        len -= take;
+        if (prefs.putBytes(chunkKey(key, n).c_str(), chunk, l) != l) return false;
+        n++;
+        l = 0;
+    }
+    return true;
+}
+
+bool AsyncWiFiSettingsNVSStorage::rename(const String &from, const String &to) {
+    if (!chunkLength(from, 0)) return AsyncWiFiSettingsStorage::rename(from, to);
+
+    uint8_t chunk[ASYNCWIFISETTINGS_CHUNK_SIZE];
+    size_t n, l;
+    for (n = 0; (l = chunkLength(from, n)); n++) {
+        prefs.getBytes(chunkKey(from, n).c_str(), chunk, sizeof(chunk));
+        if (prefs.putBytes(chunkKey(to, n).c_str(), chunk, l) != l) return false;
+    }
+    // Left over from a longer or string value
+    for (; chunkLength(to, n); n++) {
+        if (!prefs.remove(chunkKey(to, n).c_str())) return false;
+    }
+    String k = nvsKey(to);
+    if (prefs.isKey(k.c_str()) && !prefs.remove(k.c_str())) return false;
+    return write(from, "");
+}
+
+String AsyncWiFiSettingsRAMStorage::read(const String &key) {
+    auto it = values.find(key);
+    return it == values.end() ? String() : it->second;
+}
+
+bool AsyncWiFiSettingsRAMStorage::write(const String &key, const String &value) {
+    if (value.isEmpty())
+        values.erase(key);
+    else
+        values[key] = value;
+    return true;
+}
+
+bool AsyncWiFiSettingsRAMStorage::exists(const String &key) {
+    return values.count(key) == 1;
+}
+
+size_t AsyncWiFiSettingsRAMStorage::size(const String &key) {
+    auto it = values.find(key);
+    return it == values.end() ? 0 : it->second.length();
+}
+
+size_t AsyncWiFiSettingsRAMStorage::readChunk(const String &key, size_t offset, uint8_t *buf, size_t len) {
+    auto it = values.find(key);
+    if (it == values.end() || offset >= it->second.length()) return 0;
+    if (len > it->second.length() - offset) len = it->second.length() - offset;
+    memcpy(buf, it->second.c_str() + offset, len);
+    return len;
+}
+
+bool AsyncWiFiSettingsRAMStorage::append(const String &key, const uint8_t *buf, size_t len) {
+    return values[key].concat((const char *)buf, len);
+}
+
+bool AsyncWiFiSettingsRAMStorage::rename(const String &from, const String &to) {
+    auto it = values.find(from);
+    if (it == values.end()) {
+        values.erase(to);
+        return true;
+    }
+    String v = it->second;
+    values.erase(it);
+    values[to] = v;
+    return true;
+}
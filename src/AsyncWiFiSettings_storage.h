@@ -0,0 +1,88 @@
+#ifndef AsyncWiFiSettings_storage_h
+#define AsyncWiFiSettings_storage_h
+
+#include <Arduino.h>
+#include <FS.h>
+#include <Preferences.h>
+
+#include <map>
+
+#ifndef ASYNCWIFISETTINGS_CHUNK_SIZE
+#define ASYNCWIFISETTINGS_CHUNK_SIZE 256
+#endif
+
+// Where values are kept. Keys are parameter names, or one of the built-in
+// keys "wifi-ssid", "wifi-password" and "AsyncWiFiSettings-language".
+// Writing an empty value removes the key. Renaming replaces the value of the
+// target, and removes the source.
+//
+// Large values (blobs) are accessed in chunks instead. The default
+// implementations of the chunked functions and of rename go through a whole
+// String, and should be overridden by backends that can do better.
+class AsyncWiFiSettingsStorage {
+    public:
+        virtual ~AsyncWiFiSettingsStorage() {}
+        virtual String read(const String& key) = 0;
+        virtual bool write(const String& key, const String& value) = 0;
+        virtual bool exists(const String& key) = 0;
+        virtual size_t size(const String& key);
+        virtual size_t readChunk(const String& key, size_t offset, uint8_t* buf, size_t len);
+        virtual bool append(const String& key, const uint8_t* buf, size_t len);
+        virtual bool rename(const String& from, const String& to);
+};
+
+// One file per key in the root directory of a flash filesystem, such as
+// SPIFFS (the default) or LittleFS. The caller is responsible for mounting.
+class AsyncWiFiSettingsFSStorage : public AsyncWiFiSettingsStorage {
+    public:
+        AsyncWiFiSettingsFSStorage(fs::FS& fs) : fs(fs) {}
+        String read(const String& key);
+        bool write(const String& key, const String& value);
+        bool exists(const String& key);
+        size_t size(const String& key);
+        size_t readChunk(const String& key, size_t offset, uint8_t* buf, size_t len);
+        bool append(const String& key, const uint8_t* buf, size_t len);
+        bool rename(const String& from, const String& to);
+    private:
+        fs::FS& fs;
+};
+
+// Key/value pairs in a namespace of the NVS partition. NVS keys and
+// namespaces are limited to 15 characters; longer ones are shortened with a
+// hash. Blobs are split
+// over one NVS entry per ASYNCWIFISETTINGS_CHUNK_SIZE bytes, because NVS
+// can only read and write entries as a whole. NVS can't rename entries, so
+// rename copies the chunks one at a time, and only then removes the source.
+class AsyncWiFiSettingsNVSStorage : public AsyncWiFiSettingsStorage {
+    public:
+        AsyncWiFiSettingsNVSStorage(const String& ns = "wifisettings");
+        String read(const String& key);
+        bool write(const String& key, const String& value);
+        bool exists(const String& key);
+        size_t size(const String& key);
+        size_t readChunk(const String& key, size_t offset, uint8_t* buf, size_t len);
+        bool append(const String& key, const uint8_t* buf, size_t len);
+        bool rename(const String& from, const String& to);
+    private:
+        String ns;
+        Preferences prefs;
+        bool begun = false;
+        Preferences& open();
+        size_t chunkLength(const String& key, size_t n);
+};
+
+// Volatile, for testing and for devices that get their settings elsewhere.
+class AsyncWiFiSettingsRAMStorage : public AsyncWiFiSettingsStorage {
+    public:
+        String read(const String& key);
+        bool write(const String& key, const String& value);
+        bool exists(const String& key);
+        size_t size(const String& key);
+        size_t readChunk(const String& key, size_t offset, uint8_t* buf, size_t len);
+        bool append(const String& key, const uint8_t* buf, size_t len);
+        bool rename(const String& from, const String& to);
+    private:
+        std::map<String, String> values;
+};
+
+#endif
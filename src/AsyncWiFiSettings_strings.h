@@ -1,15 +1,14 @@
-#include <map>
-
 namespace AsyncWiFiSettingsLanguage {
 
 struct Texts {
-    const __FlashStringHelper
+    const char
         *title,
         *portal_wpa,
         *portal_password,
         *wait,
         *bye,
         *error_fs,
+        *saved,
         *button_save,
         *button_restart,
         *scanning_short,
@@ -18,13 +17,21 @@ struct Texts {
         *dot1x,
         *ssid,
         *wifi_password,
-        *language
-    ;
-    const char
+        *language,
+        *upload,
+        *backup,
+        *restore,
+        *error_backup,
         *init
     ;
 };
 
+struct Language {
+    const char *code;
+    const char *name;
+    Texts texts;
+};
+
 #if \
    !defined LANGUAGE_EN \
 && !defined LANGUAGE_NL \
@@ -32,100 +39,114 @@ struct Texts {
     #define LANGUAGE_ALL
 #endif
 
-std::map<const String, const String> languages {
-// Ordered alphabetically
+// Ordered alphabetically. The position in this table is the language id.
+// Members of Texts are listed in declaration order.
+constexpr Language languages[] = {
 #if defined LANGUAGE_DE || defined LANGUAGE_ALL
-    { "de", "Deutsch" },
+    { "de", "Deutsch", {
+        "Konfiguration",
+        "Das Konfigurationsportal mit einem Passwort schützen",
+        "Passwort für das Konfigurationsportal",
+        "Warten...",
+        "Tschüss!",
+        "Fehler beim Schreiben auf das Flash-Dateisystem",
+        "Gespeichert",
+        "Speichern",
+        "Gerät neustarten",
+        "Suchen...",
+        "Suche nach WiFi-Netzwerken...",
+        "Erneut suchen",
+        "(nicht möglich: 802.1x nicht unterstützt)",
+        "WiFi Netzwerkname (SSID)",
+        "WiFi Passwort",
+        "Sprache",
+        "Hochladen",
+        "Sicherung herunterladen",
+        "Wiederherstellen",
+        "Ungültige Sicherung",
+        "Standard",
+    } },
 #endif
 #if defined LANGUAGE_EN || defined LANGUAGE_ALL
-    { "en", "English" },
+    { "en", "English", {
+        "Configuration",
+        "Protect the configuration portal with a WiFi password",
+        "WiFi password for the configuration portal",
+        "Wait for it...",
+        "Bye!",
+        "Error while writing to flash filesystem.",
+        "Saved",
+        "Save",
+        "Restart device",
+        "Scanning...",
+        "Scanning for WiFi networks...",
+        "rescan",
+        "(won't work: 802.1x is not supported)",
+        "WiFi network name (SSID)",
+        "WiFi password",
+        "Language",
+        "Upload",
+        "Download backup",
+        "Restore",
+        "Invalid backup.",
+        "default",
+    } },
 #endif
 #if defined LANGUAGE_NL || defined LANGUAGE_ALL
-    { "nl", "Nederlands" },
+    { "nl", "Nederlands", {
+        "Configuratie",
+        "Beveilig de configuratieportal met een WiFi-wachtwoord",
+        "WiFi-wachtwoord voor de configuratieportal",
+        "Even wachten...",
+        "Doei!",
+        "Fout bij het schrijven naar het flash-bestandssysteem.",
+        "Opgeslagen",
+        "Opslaan",
+        "Herstarten",
+        "Scant...",
+        "Zoeken naar WiFi-netwerken...",
+        "opnieuw scannen",
+        "(werkt niet: 802.1x wordt niet ondersteund)",
+        "WiFi-netwerknaam (SSID)",
+        "WiFi-wachtwoord",
+        "Taal",
+        "Uploaden",
+        "Back-up downloaden",
+        "Terugzetten",
+        "Ongeldige back-up.",
+        "standaard",
+    } },
 #endif
 };
 
+constexpr uint8_t count = sizeof(languages) / sizeof(languages[0]);
+
+// Returns the id of the language, or `count` if it isn't available.
+uint8_t find(const String& language) {
+    for (uint8_t id = 0; id < count; id++) {
+        if (language == languages[id].code) return id;
+    }
+    return count;
+}
+
 bool available(const String& language) {
-    return languages.count(language) == 1;
+    return find(language) < count;
 }
 
 bool multiple() {
-    return languages.size() > 1;
+    return count > 1;
 }
 
-bool select(Texts& T, String& language) {
-    if (! available(language)) {
-        if (available("en")) language = "en";
-        else language = languages.begin()->first;
+// Returns the id of the language, falling back to English or else the
+// first available language. Can update language.
+uint8_t select(String& language) {
+    uint8_t id = find(language);
+    if (id == count) {
+        id = find("en");
+        if (id == count) id = 0;
+        language = languages[id].code;
     }
-
-#if defined LANGUAGE_EN || defined LANGUAGE_ALL
-    if (language == "en") {
-        T.title = F("Configuration");
-        T.portal_wpa = F("Protect the configuration portal with a WiFi password");
-        T.portal_password = F("WiFi password for the configuration portal");
-        T.init = "default";
-        T.wait = F("Wait for it...");
-        T.bye = F("Bye!");
-        T.error_fs = F("Error while writing to flash filesystem.");
-        T.button_save = F("Save");
-        T.button_restart = F("Restart device");
-        T.scanning_short = F("Scanning...");
-        T.scanning_long = F("Scanning for WiFi networks...");
-        T.rescan = F("rescan");
-        T.dot1x = F("(won't work: 802.1x is not supported)");
-        T.ssid = F("WiFi network name (SSID)");
-        T.wifi_password = F("WiFi password");
-        T.language = F("Language");
-        return true;
-    }
-#endif
-
-#if defined LANGUAGE_NL || defined LANGUAGE_ALL
-    if (language == "nl") {
-        T.title = F("Configuratie");
-        T.portal_wpa = F("Beveilig de configuratieportal met een WiFi-wachtwoord");
-        T.portal_password = F("WiFi-wachtwoord voor de configuratieportal");
-        T.init = "standaard";
-        T.wait = F("Even wachten...");
-        T.bye = F("Doei!");
-        T.error_fs = F("Fout bij het schrijven naar het flash-bestandssysteem.");
-        T.button_save = F("Opslaan");
-        T.button_restart = F("Herstarten");
-        T.scanning_short = F("Scant...");
-        T.scanning_long = F("Zoeken naar WiFi-netwerken...");
-        T.rescan = F("opnieuw scannen");
-        T.dot1x = F("(werkt niet: 802.1x wordt niet ondersteund)");
-        T.ssid = F("WiFi-netwerknaam (SSID)");
-        T.wifi_password = F("WiFi-wachtwoord");
-        T.language = F("Taal");
-        return true;
-    }
-#endif
-
-#if defined LANGUAGE_DE || defined LANGUAGE_ALL
-    if (language == "de") {
-        T.title = F("Konfiguration");
-        T.portal_wpa = F("Das Konfigurationsportal mit einem Passwort schützen");
-        T.portal_password = F("Passwort für das Konfigurationsportal");
-        T.init = "Standard";
-        T.wait = F("Warten...");
-        T.bye = F("Tschüss!");
-        T.error_fs = F("Fehler beim Schreiben auf das Flash-Dateisystem");
-        T.button_save = F("Speichern");
-        T.button_restart = F("Gerät neustarten");
-        T.scanning_short = F("Suchen...");
-        T.scanning_long = F("Suche nach WiFi-Netzwerken...");
-        T.rescan = F("Erneut suchen");
-        T.dot1x = F("(nicht möglich: 802.1x nicht unterstützt)");
-        T.ssid = F("WiFi Netzwerkname (SSID)");
-        T.wifi_password = F("WiFi Passwort");
-        T.language = F("Sprache");
-        return true;
-    }
-#endif
-
-    return false;
+    return id;
 }
 
 } // namespace
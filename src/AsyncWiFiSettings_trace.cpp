@@ -0,0 +1,15 @@
+#include "AsyncWiFiSettings_trace.h"
+
+void AsyncWiFiSettingsTrace::print(Print &out) {
+#if ASYNCWIFISETTINGS_TRACE
+    uint32_t n = total < ASYNCWIFISETTINGS_TRACE ? total : ASYNCWIFISETTINGS_TRACE;
+    if (total > n) out.printf("# %u older events dropped\n", (unsigned int)(total - n));
+    out.print(F("# start_us duration_us phase detail\n"));
+    for (uint32_t i = total - n; i < total; i++) {
+        const Event &e = events[i % ASYNCWIFISETTINGS_TRACE];
+        out.printf("%10u %10u %s %s\n", (unsigned int)e.start, (unsigned int)e.us, e.phase, e.detail);
+    }
+#else
+    (void)out;
+#endif
+}
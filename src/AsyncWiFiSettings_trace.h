@@ -0,0 +1,57 @@
+#ifndef AsyncWiFiSettings_trace_h
+#define AsyncWiFiSettings_trace_h
+
+#include <Arduino.h>
+
+// Build with -DASYNCWIFISETTINGS_TRACE=<number of events> to keep a trace of
+// the boot phases in a ring buffer, served on /boot-trace. Otherwise, all
+// recording compiles to nothing.
+#ifndef ASYNCWIFISETTINGS_TRACE
+#define ASYNCWIFISETTINGS_TRACE 0
+#endif
+
+struct AsyncWiFiSettingsTrace {
+    struct Event {
+        uint32_t start; // micros() since boot
+        uint32_t us;
+        const char* phase;
+        const char* detail;
+    };
+
+#if ASYNCWIFISETTINGS_TRACE
+    Event events[ASYNCWIFISETTINGS_TRACE];
+    uint32_t total = 0;
+#endif
+
+    void record(const char* phase, const char* detail, uint32_t start, uint32_t us) {
+#if ASYNCWIFISETTINGS_TRACE
+        events[total++ % ASYNCWIFISETTINGS_TRACE] = {start, us, phase, detail};
+#else
+        (void)phase; (void)detail; (void)start; (void)us;
+#endif
+    }
+
+    // Oldest first, one event per line
+    void print(Print& out);
+};
+
+// Records the time from construction to destruction as one event
+class AsyncWiFiSettingsTraceScope {
+    public:
+#if ASYNCWIFISETTINGS_TRACE
+        AsyncWiFiSettingsTraceScope(AsyncWiFiSettingsTrace& trace, const char* phase, const char* detail = "")
+            : trace(trace), phase(phase), detail(detail), start(micros()) {}
+        ~AsyncWiFiSettingsTraceScope() { trace.record(phase, detail, start, micros() - start); }
+    private:
+        AsyncWiFiSettingsTrace& trace;
+        const char* phase;
+        const char* detail;
+        uint32_t start;
+#else
+        AsyncWiFiSettingsTraceScope(AsyncWiFiSettingsTrace& trace, const char* phase, const char* detail = "") {
+            (void)trace; (void)phase; (void)detail;
+        }
+#endif
+};
+
+#endif